@@ -25,11 +25,15 @@
 
 #include "builddirmanager.h"
 #include "cmakebuildconfiguration.h"
+#include "cmakecompilercache.h"
 #include "cmakekitinformation.h"
 #include "cmakeparser.h"
 #include "cmakeprojectmanager.h"
 #include "cmaketool.h"
+#include "cmaketoolmanager.h"
 
+#include <coreplugin/editormanager/editormanager.h>
+#include <coreplugin/idocument.h>
 #include <coreplugin/messagemanager.h>
 #include <coreplugin/progressmanager/progressmanager.h>
 #include <projectexplorer/kit.h>
@@ -43,6 +47,7 @@
 #include <utils/fileutils.h>
 #include <utils/qtcassert.h>
 #include <utils/qtcprocess.h>
+#include <utils/runextensions.h>
 #include <utils/synchronousprocess.h>
 
 #include <QDateTime>
@@ -76,23 +81,66 @@ static QStringList toArguments(const CMakeConfig &config, const ProjectExplorer:
 
 BuildDirManager::BuildDirManager(const CMakeBuildConfiguration *bc) :
     m_buildConfiguration(bc),
-    m_watcher(new QFileSystemWatcher(this))
+    m_watcher(new QFileSystemWatcher(this)),
+    m_targetFlagsCache(new CMakeTargetFlagsCache)
 {
     QTC_ASSERT(bc, return);
     m_projectName = sourceDirectory().fileName();
 
     m_reparseTimer.setSingleShot(true);
     m_reparseTimer.setInterval(500);
-    connect(&m_reparseTimer, &QTimer::timeout, this, &BuildDirManager::parse);
+    connect(&m_reparseTimer, &QTimer::timeout, this, &BuildDirManager::reparseWhenIdle);
+
+    // Changes during a parse count as well, reparseWhenIdle() waits for the parse to finish.
+    // But cmake itself rewrites the .cbp file and the files it generates into the build
+    // directory while it runs, and those changes are what the parse is about to pick up.
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path) {
+        if (isParsing()) {
+            const Utils::FileName file = Utils::FileName::fromString(path);
+            if (!isProjectFile(file) || file.isChildOf(workDirectory()))
+                return;
+        }
+        m_reparseTimer.start();
+    });
+
+    // Configure right away instead of after the watcher and the reparse timer noticed the
+    // change, so that a build started next usually finds fresh data.
+    connect(Core::EditorManager::instance(), &Core::EditorManager::saved,
+            this, [this](Core::IDocument *document) {
+                if (m_buildConfiguration->reconfigureOnSave() && isProjectFile(document->filePath())) {
+                    m_reparseTimer.stop();
+                    reparseWhenIdle();
+                }
+            });
+
+    connect(CMakeToolManager::instance(), &CMakeToolManager::cmakeUpdated,
+            this, &BuildDirManager::toolUpdated);
 
-    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, [this]() {
-        if (!isParsing())
-            m_reparseTimer.start();
+    connect(&m_snapshotValidation, &QFutureWatcher<bool>::finished, this, [this]() {
+        if (m_snapshotValidation.isCanceled() || m_snapshotValidation.result())
+            return;
+        // Something changed while the project was closed
+        m_snapshot = CMakeProjectSnapshot();
+        parse();
+    });
+
+    connect(&m_ninjaLogUpdate, &QFutureWatcherBase::finished, this, [this]() {
+        if (m_ninjaLogUpdate.future().resultCount() > 0)
+            m_ninjaLog = m_ninjaLogUpdate.result();
+        if (m_ninjaLogOutdated) {
+            m_ninjaLogOutdated = false;
+            updateBuildReport();
+            return;
+        }
+        emit buildEstimateAvailable();
     });
 }
 
 BuildDirManager::~BuildDirManager()
 {
+    m_snapshotValidation.cancel();
+    m_ninjaLogUpdate.cancel();
+    saveSnapshot(); // The target flags might have been read since the snapshot was written
     stopProcess();
     resetData();
     delete m_tempDir;
@@ -178,20 +226,54 @@ void BuildDirManager::forceReparse()
     stopProcess();
 
     CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
-    const QString generator = CMakeGeneratorKitInformation::generator(kit());
-
     QTC_ASSERT(tool, return);
+    if (deferUntilValidated(tool, true))
+        return;
+
+    const QString generator = CMakeGeneratorKitInformation::generator(kit());
     QTC_ASSERT(!generator.isEmpty(), return);
 
     startCMake(tool, generator, intendedConfiguration(), cmakeToolchainInfo());
 }
 
+// The kit knows its generator only once the tool is validated, and waiting for that would
+// block the GUI, so the parse runs when CMakeToolManager reports the tool as updated.
+bool BuildDirManager::deferUntilValidated(const CMakeTool *tool, bool force)
+{
+    if (!tool->isValidationPending())
+        return false;
+    if (force)
+        m_pendingParse = PendingForcedReparse;
+    else if (m_pendingParse == NoPendingParse)
+        m_pendingParse = PendingParse;
+    return true;
+}
+
+void BuildDirManager::toolUpdated(const Core::Id &id)
+{
+    if (m_pendingParse == NoPendingParse)
+        return;
+    const CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
+    if (!tool || tool->id() != id || tool->isValidationPending())
+        return;
+    const PendingParse pendingParse = m_pendingParse;
+    m_pendingParse = NoPendingParse;
+    if (pendingParse == PendingForcedReparse)
+        forceReparse();
+    else
+        parse();
+}
+
 void BuildDirManager::resetData()
 {
     m_hasData = false;
 
+    m_snapshotValidation.cancel();
+    m_snapshot = CMakeProjectSnapshot();
+
     m_projectName.clear();
     m_buildTargets.clear();
+    m_affectedTargets.clear();
     m_watchedFiles.clear();
     qDeleteAll(m_files);
     m_files.clear();
@@ -216,12 +298,23 @@ bool BuildDirManager::persistCMakeState()
     return true;
 }
 
+// A change during a cmake run might have been too late for it, so check again afterwards
+void BuildDirManager::reparseWhenIdle()
+{
+    if (isParsing())
+        m_reparseTimer.start();
+    else
+        parse();
+}
+
 void BuildDirManager::parse()
 {
     CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
-    const QString generator = CMakeGeneratorKitInformation::generator(kit());
-
     QTC_ASSERT(tool, return);
+    if (deferUntilValidated(tool, false))
+        return;
+
+    const QString generator = CMakeGeneratorKitInformation::generator(kit());
     QTC_ASSERT(!generator.isEmpty(), return);
 
     // Pop up a dialog asking the user to rerun cmake
@@ -234,6 +327,18 @@ void BuildDirManager::parse()
         return;
     }
 
+    if (m_watchedFiles.isEmpty() && loadSnapshot(cbpFile)) {
+        // Reopened project: Show what was there right away, and check in the background
+        // whether that is still up to date.
+        m_hasData = true;
+        emit dataAvailable();
+        const CMakeProjectSnapshot snapshot = m_snapshot;
+        m_snapshotValidation.setFuture(Utils::runAsync([snapshot]() {
+            return snapshot.isUpToDate();
+        }));
+        return;
+    }
+
     const bool mustUpdate = m_watchedFiles.isEmpty()
             || Utils::anyOf(m_watchedFiles, [&cbpFileFi](const Utils::FileName &f) {
                   return f.toFileInfo().lastModified() > cbpFileFi.lastModified();
@@ -267,6 +372,11 @@ bool BuildDirManager::isProjectFile(const Utils::FileName &fileName) const
     return m_watchedFiles.contains(fileName);
 }
 
+QList<Utils::FileName> BuildDirManager::cmakeFiles() const
+{
+    return m_watchedFiles.toList();
+}
+
 QString BuildDirManager::projectName() const
 {
     return m_projectName;
@@ -277,6 +387,49 @@ QList<CMakeBuildTarget> BuildDirManager::buildTargets() const
     return m_buildTargets;
 }
 
+// Called before and after every build, so that the build history does not miss builds.
+// The log grows with every build, so it is read in a worker thread.
+void BuildDirManager::updateBuildReport()
+{
+    if (m_ninjaLogUpdate.isRunning()) {
+        m_ninjaLogOutdated = true;
+        return;
+    }
+    const CMakeNinjaLog log = m_ninjaLog;
+    const Utils::FileName buildDir = buildDirectory();
+    const QList<CMakeBuildTarget> targets = m_buildTargets;
+    m_ninjaLogUpdate.setFuture(Utils::runAsync([log, buildDir, targets]() {
+        CMakeNinjaLog updated = log;
+        updated.update(buildDir, targets);
+        return updated;
+    }));
+}
+
+// The user asked for it, so this waits for the log
+CMakeBuildReport BuildDirManager::buildReport()
+{
+    m_ninjaLogUpdate.waitForFinished();
+    if (m_ninjaLogUpdate.future().resultCount() > 0)
+        m_ninjaLog = m_ninjaLogUpdate.result();
+    m_ninjaLogOutdated = false;
+    // Drops the notification about the result taken above
+    m_ninjaLogUpdate.setFuture(QFuture<CMakeNinjaLog>());
+    m_ninjaLog.update(buildDirectory(), m_buildTargets);
+    return m_ninjaLog.report(100);
+}
+
+// From the log as of the last update, without history before the first one finished
+CMakeBuildEstimate BuildDirManager::buildEstimate() const
+{
+    return m_ninjaLog.estimate();
+}
+
+QStringList BuildDirManager::affectedTargets(const QStringList &modifiedFiles)
+{
+    m_affectedTargets.update(buildDirectory(), m_buildTargets);
+    return m_affectedTargets.targets(modifiedFiles);
+}
+
 QList<ProjectExplorer::FileNode *> BuildDirManager::files()
 {
     return m_files;
@@ -294,18 +447,32 @@ CMakeConfig BuildDirManager::parsedConfiguration() const
 
     Utils::FileName cacheFile = workDirectory();
     cacheFile.appendPath(QLatin1String("CMakeCache.txt"));
+    const QDateTime lastModified = cacheFile.toFileInfo().lastModified();
+    if (lastModified.isValid() && lastModified == m_parsedConfigurationLastModified)
+        return m_parsedConfiguration;
+
     QString errorMessage;
     CMakeConfig result = parseConfiguration(cacheFile, &errorMessage);
     if (!errorMessage.isEmpty())
         emit errorOccured(errorMessage);
     const Utils::FileName sourceOfBuildDir
             = Utils::FileName::fromUtf8(CMakeConfigItem::valueOf("CMAKE_HOME_DIRECTORY", result));
-    if (sourceOfBuildDir != sourceDirectory()) // Use case-insensitive compare where appropriate
+    if (sourceOfBuildDir != sourceDirectory()) { // Use case-insensitive compare where appropriate
         emit errorOccured(tr("The build directory is not for %1").arg(sourceDirectory().toUserOutput()));
+    } else if (errorMessage.isEmpty()) {
+        // Only read the cache again when it changed
+        m_parsedConfiguration = result;
+        m_parsedConfigurationLastModified = lastModified;
+    }
 
     return result;
 }
 
+QSharedPointer<CMakeTargetFlagsCache> BuildDirManager::targetFlagsCache() const
+{
+    return m_targetFlagsCache;
+}
+
 void BuildDirManager::stopProcess()
 {
     if (!m_cmakeProcess)
@@ -350,6 +517,7 @@ void BuildDirManager::cleanUpProcess()
     m_parser->flush();
     delete m_parser;
     m_parser = nullptr;
+    m_taskAggregator.finish();
 }
 
 void BuildDirManager::extractData()
@@ -372,6 +540,7 @@ void BuildDirManager::extractData()
 
     // setFolderName
     CMakeCbpParser cbpparser;
+    cbpparser.setDirectoryInformationCache(&m_directoryInformationCache);
     // Parsing
     if (!cbpparser.parseCbpFile(kit(), cbpFile, sourceDirectory().toString()))
         return;
@@ -395,12 +564,78 @@ void BuildDirManager::extractData()
     m_watcher->addPaths(toWatch);
 
     m_buildTargets = cbpparser.buildTargets();
+
+    m_snapshot.sourceDirectory = sourceDirectory().toString();
+    m_snapshot.cbpFile = cbpFile;
+    m_snapshot.cbpFileLastModified = QFileInfo(cbpFile).lastModified();
+    m_snapshot.kitId = kit()->id().name();
+    if (CMakeTool *tool = CMakeKitInformation::cmakeTool(kit()))
+        m_snapshot.cmakeToolId = tool->id().name();
+    m_snapshot.projectName = m_projectName;
+    m_snapshot.buildTargets = m_buildTargets;
+    m_snapshot.files = Utils::transform(m_files, [](const ProjectExplorer::FileNode *node) {
+        CMakeProjectSnapshot::File file;
+        file.path = node->filePath();
+        file.type = node->fileType();
+        file.isGenerated = node->isGenerated();
+        return file;
+    });
+    m_snapshot.watchedFiles = m_watchedFiles.toList();
+    saveSnapshot();
+}
+
+bool BuildDirManager::loadSnapshot(const QString &cbpFile)
+{
+    if (m_tempDir)
+        return false;
+
+    // Code model updates may be reading the current flags, which stay until the snapshot is taken
+    CMakeProjectSnapshot snapshot;
+    QSharedPointer<CMakeTargetFlagsCache> flagsCache(new CMakeTargetFlagsCache);
+    if (!snapshot.load(CMakeProjectSnapshot::fileName(buildDirectory()), flagsCache.data()))
+        return false;
+
+    // The cbp file is the only input that is checked right away
+    CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
+    if (snapshot.sourceDirectory != sourceDirectory().toString()
+            || snapshot.cbpFile != cbpFile
+            || snapshot.cbpFileLastModified != QFileInfo(cbpFile).lastModified()
+            || snapshot.kitId != kit()->id().name()
+            || !tool || snapshot.cmakeToolId != tool->id().name()) {
+        return false;
+    }
+
+    resetData();
+    m_targetFlagsCache = flagsCache;
+    m_snapshot = snapshot;
+    m_projectName = snapshot.projectName;
+    m_buildTargets = snapshot.buildTargets;
+    foreach (const CMakeProjectSnapshot::File &file, snapshot.files)
+        m_files.append(new ProjectExplorer::FileNode(file.path, file.type, file.isGenerated));
+    m_watchedFiles = snapshot.watchedFiles.toSet();
+    m_parsedConfiguration = snapshot.parsedConfiguration;
+    m_parsedConfigurationLastModified = snapshot.parsedConfigurationLastModified;
+
+    m_watcher->addPath(cbpFile);
+    const QStringList toWatch
+            = Utils::transform(m_watchedFiles.toList(), [](const Utils::FileName &fn) { return fn.toString(); });
+    m_watcher->addPaths(toWatch);
+    return true;
+}
+
+void BuildDirManager::saveSnapshot()
+{
+    if (!m_snapshot.isValid() || m_tempDir)
+        return;
+    m_snapshot.parsedConfiguration = m_parsedConfiguration;
+    m_snapshot.parsedConfigurationLastModified = m_parsedConfigurationLastModified;
+    m_snapshot.save(CMakeProjectSnapshot::fileName(buildDirectory()), *m_targetFlagsCache);
 }
 
 void BuildDirManager::startCMake(CMakeTool *tool, const QString &generator,
                                  const CMakeConfig &config, const CMakeToolchainInfo &toolchain)
 {
-    QTC_ASSERT(tool && tool->isValid(), return);
+    QTC_ASSERT(tool && !tool->isValidationPending() && tool->isValid(), return);
 
     QTC_ASSERT(!m_cmakeProcess, return);
     QTC_ASSERT(!m_parser, return);
@@ -419,13 +654,13 @@ void BuildDirManager::startCMake(CMakeTool *tool, const QString &generator,
     m_parser = new CMakeParser;
     QDir source = QDir(sourceDirectory().toString());
     connect(m_parser, &ProjectExplorer::IOutputParser::addTask, m_parser,
-            [source](const ProjectExplorer::Task &task) {
+            [this, source](const ProjectExplorer::Task &task) {
                 if (task.file.isEmpty() || task.file.toFileInfo().isAbsolute()) {
-                    ProjectExplorer::TaskHub::addTask(task);
+                    m_taskAggregator.addTask(task);
                 } else {
                     ProjectExplorer::Task t = task;
                     t.file = Utils::FileName::fromString(source.absoluteFilePath(task.file.toString()));
-                    ProjectExplorer::TaskHub::addTask(t);
+                    m_taskAggregator.addTask(t);
                 }
             });
 
@@ -451,7 +686,19 @@ void BuildDirManager::startCMake(CMakeTool *tool, const QString &generator,
     Utils::QtcProcess::addArgs(&args, toArguments(config, kit()));
     Utils::QtcProcess::addArgs(&args, toolchain.arguments(toArguments(config, kit()), workDirectory().toString()));
 
+    // Reparses pass no configuration, so the cache tells which launcher is in use
+    Utils::FileName cacheFile = workDirectory();
+    cacheFile.appendPath(QLatin1String("CMakeCache.txt"));
+    const CMakeConfig cache = m_hasData ? parsedConfiguration()
+                                        : parseConfiguration(cacheFile, nullptr);
+    // A launcher that is gone is ignored, as the kit says, rather than failing every compile
+    Utils::FileName launcher = CMakeCompilerCacheKitInformation::launcher(kit());
+    if (!launcher.toFileInfo().isExecutable())
+        launcher.clear();
+    Utils::QtcProcess::addArgs(&args, CMakeCompilerCache::configureArguments(launcher, config, cache));
+
     ProjectExplorer::TaskHub::clearTasks(ProjectExplorer::Constants::TASK_CATEGORY_BUILDSYSTEM);
+    m_taskAggregator.clear();
 
     Core::MessageManager::write(tr("Running \"%1 %2\" in %3.")
                                 .arg(tool->cmakeExecutable().toUserOutput())
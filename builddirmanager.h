@@ -25,8 +25,13 @@
 
 #pragma once
 
+#include "cmakeaffectedtargets.h"
+#include "cmakebuildreport.h"
 #include "cmakecbpparser.h"
 #include "cmakeconfigitem.h"
+#include "cmakeprojectsnapshot.h"
+#include "cmaketaskaggregator.h"
+#include "cmaketargetflags.h"
 #include "cmaketoolchaininfo.h"
 
 #include <projectexplorer/task.h>
@@ -37,8 +42,10 @@
 
 #include <QByteArray>
 #include <QFutureInterface>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QSet>
+#include <QSharedPointer>
 #include <QTimer>
 
 QT_FORWARD_DECLARE_CLASS(QTemporaryDir);
@@ -84,11 +91,18 @@ public:
     bool persistCMakeState();
 
     bool isProjectFile(const Utils::FileName &fileName) const;
+    QList<Utils::FileName> cmakeFiles() const;
     QString projectName() const;
     QList<CMakeBuildTarget> buildTargets() const;
     QList<ProjectExplorer::FileNode *> files();
     void clearFiles();
     CMakeConfig parsedConfiguration() const;
+    QSharedPointer<CMakeTargetFlagsCache> targetFlagsCache() const;
+
+    void updateBuildReport();
+    CMakeBuildReport buildReport();
+    CMakeBuildEstimate buildEstimate() const;
+    QStringList affectedTargets(const QStringList &modifiedFiles);
 
     static CMakeConfig parseConfiguration(const Utils::FileName &cacheFile,
                                           QString *errorMessage);
@@ -97,12 +111,18 @@ signals:
     void configurationStarted() const;
     void dataAvailable() const;
     void errorOccured(const QString &err) const;
+    void buildEstimateAvailable() const;
 
 private:
+    void reparseWhenIdle();
     void stopProcess();
     void cleanUpProcess();
     void extractData();
+    bool loadSnapshot(const QString &cbpFile);
+    void saveSnapshot();
 
+    bool deferUntilValidated(const CMakeTool *tool, bool force);
+    void toolUpdated(const Core::Id &id);
     void startCMake(CMakeTool *tool, const QString &generator, const CMakeConfig &config, const CMakeToolchainInfo &toolchain);
 
     void cmakeFinished(int code, QProcess::ExitStatus status);
@@ -121,12 +141,29 @@ private:
     QList<CMakeBuildTarget> m_buildTargets;
     QFileSystemWatcher *m_watcher;
     QList<ProjectExplorer::FileNode *> m_files;
+    QSharedPointer<CMakeTargetFlagsCache> m_targetFlagsCache; // shared with code model updates
+    CMakeDirectoryInformationCache m_directoryInformationCache;
+    mutable CMakeConfig m_parsedConfiguration;
+    mutable QDateTime m_parsedConfigurationLastModified;
+
+    CMakeProjectSnapshot m_snapshot;
+    QFutureWatcher<bool> m_snapshotValidation;
+
+    CMakeNinjaLog m_ninjaLog;
+    QFutureWatcher<CMakeNinjaLog> m_ninjaLogUpdate;
+    bool m_ninjaLogOutdated = false; // a build finished while the log was read
+    CMakeAffectedTargets m_affectedTargets;
 
     // For error reporting:
     ProjectExplorer::IOutputParser *m_parser = nullptr;
+    CMakeTaskAggregator m_taskAggregator;
     QFutureInterface<void> *m_future = nullptr;
 
     QTimer m_reparseTimer;
+
+    // The parse to run once the CMake tool of the kit is validated
+    enum PendingParse { NoPendingParse, PendingParse, PendingForcedReparse };
+    PendingParse m_pendingParse = NoPendingParse;
 };
 
 } // namespace Internal
@@ -0,0 +1,365 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakeaffectedtargets.h"
+
+#include <utils/algorithm.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+namespace {
+
+// Splits a ninja build statement into paths, resolving the "$ ", "$:" and "$$" escapes.
+// The ':' between the outputs and the rule is a token of its own.
+QStringList ninjaTokens(const QByteArray &statement)
+{
+    QStringList tokens;
+    QByteArray token;
+    auto flush = [&tokens, &token]() {
+        if (!token.isEmpty()) {
+            tokens.append(QString::fromUtf8(token));
+            token.clear();
+        }
+    };
+
+    for (int i = 0; i < statement.size(); ++i) {
+        const char c = statement.at(i);
+        if (c == '$' && i + 1 < statement.size()) {
+            token.append(statement.at(++i));
+        } else if (c == ' ') {
+            flush();
+        } else if (c == ':') {
+            flush();
+            tokens.append(QLatin1String(":"));
+        } else {
+            token.append(c);
+        }
+    }
+    flush();
+    return tokens;
+}
+
+// "src/CMakeFiles/app.dir/all" -> "app"
+QString makefileTargetTitle(const QString &path)
+{
+    const QLatin1String prefix("CMakeFiles/");
+    const QLatin1String suffix(".dir/all");
+    if (!path.endsWith(suffix))
+        return QString();
+    const int start = path.lastIndexOf(prefix);
+    if (start < 0)
+        return QString();
+    return path.mid(start + prefix.size(), path.size() - suffix.size() - start - prefix.size());
+}
+
+} // namespace
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+void CMakeAffectedTargets::clear()
+{
+    m_buildDirectory.clear();
+    m_targets.clear();
+    m_targetsOfFile.clear();
+    m_outputs.clear();
+    m_dependents.clear();
+    m_dependencyFile.clear();
+    m_dependencyFileLastModified = QDateTime();
+}
+
+void CMakeAffectedTargets::update(const Utils::FileName &buildDirectory,
+                                  const QList<CMakeBuildTarget> &targets)
+{
+    if (buildDirectory != m_buildDirectory || m_targets.isEmpty())
+        setTargets(buildDirectory, targets);
+    loadDependencies();
+}
+
+void CMakeAffectedTargets::setTargets(const Utils::FileName &buildDirectory,
+                                      const QList<CMakeBuildTarget> &targets)
+{
+    clear();
+    m_buildDirectory = buildDirectory;
+
+    // Utility targets have no output to compare against, and "all" would pull in everything
+    m_targets = Utils::filtered(targets, [](const CMakeBuildTarget &target) {
+        return target.targetType != UtilityType;
+    });
+
+    const QDir buildDir(buildDirectory.toString());
+    foreach (const CMakeBuildTarget &target, m_targets) {
+        foreach (const QString &file, target.files)
+            m_targetsOfFile[file].append(target.title);
+        m_outputs.insert(target.title, target.title);
+        if (!target.executable.isEmpty())
+            m_outputs.insert(buildDir.relativeFilePath(target.executable), target.title);
+    }
+}
+
+void CMakeAffectedTargets::loadDependencies()
+{
+    Utils::FileName fileName = Utils::FileName(m_buildDirectory).appendPath(QLatin1String("build.ninja"));
+    const bool isNinja = fileName.exists();
+    if (!isNinja)
+        fileName = Utils::FileName(m_buildDirectory).appendPath(QLatin1String("CMakeFiles/Makefile2"));
+
+    const QDateTime lastModified = fileName.toFileInfo().lastModified();
+    if (fileName == m_dependencyFile && lastModified == m_dependencyFileLastModified)
+        return;
+    m_dependencyFile = fileName;
+    m_dependencyFileLastModified = lastModified;
+    m_dependents.clear();
+
+    QFile file(fileName.toString());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    if (isNinja)
+        parseNinjaDependencies(file.readAll());
+    else
+        parseMakefileDependencies(file.readAll());
+}
+
+QString CMakeAffectedTargets::targetForPath(const QString &path) const
+{
+    if (QDir::isRelativePath(path))
+        return m_outputs.value(QDir::cleanPath(path));
+    return m_outputs.value(QDir(m_buildDirectory.toString()).relativeFilePath(path));
+}
+
+void CMakeAffectedTargets::addDependency(const QString &target, const QString &dependency)
+{
+    if (!target.isEmpty() && !dependency.isEmpty() && target != dependency)
+        m_dependents[dependency].insert(target);
+}
+
+// Only the link statements matter: their output is the file of a target, and their inputs
+// include the libraries of the other targets it links against.
+void CMakeAffectedTargets::parseNinjaDependencies(const QByteArray &buildNinja)
+{
+    int pos = 0;
+    while (pos < buildNinja.size()) {
+        int end = buildNinja.indexOf('\n', pos);
+        if (end < 0)
+            end = buildNinja.size();
+        if (qstrncmp(buildNinja.constData() + pos, "build ", 6) != 0) {
+            pos = end + 1;
+            continue;
+        }
+
+        QByteArray statement = buildNinja.mid(pos + 6, end - pos - 6);
+        pos = end + 1;
+        // Long statements continue on the next line after a trailing '$'
+        while (statement.endsWith('$') && pos < buildNinja.size()) {
+            statement.chop(1);
+            end = buildNinja.indexOf('\n', pos);
+            if (end < 0)
+                end = buildNinja.size();
+            statement += buildNinja.mid(pos, end - pos).trimmed();
+            statement += ' ';
+            pos = end + 1;
+        }
+
+        const QStringList tokens = ninjaTokens(statement.trimmed());
+        const int colon = tokens.indexOf(QLatin1String(":"));
+        if (colon < 0)
+            continue;
+
+        QStringList targets;
+        for (int i = 0; i < colon; ++i) {
+            const QString target = targetForPath(tokens.at(i));
+            if (!target.isEmpty())
+                targets.append(target);
+        }
+        if (targets.isEmpty())
+            continue;
+
+        // Skip the rule, then explicit, implicit ("|") and order-only ("||") inputs alike
+        for (int i = colon + 2; i < tokens.size(); ++i) {
+            const QString dependency = targetForPath(tokens.at(i));
+            foreach (const QString &target, targets)
+                addDependency(target, dependency);
+        }
+    }
+}
+
+// The Makefile generator writes one "<dir>/CMakeFiles/<target>.dir/all: <dependency>" line
+// per dependency between targets.
+void CMakeAffectedTargets::parseMakefileDependencies(const QByteArray &makefile2)
+{
+    foreach (const QByteArray &line, makefile2.split('\n')) {
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith('\t'))
+            continue;
+        const int colon = line.indexOf(": ");
+        if (colon < 0)
+            continue;
+
+        const QString target = makefileTargetTitle(QString::fromUtf8(line.left(colon).trimmed()));
+        if (!m_outputs.contains(target))
+            continue;
+        foreach (const QByteArray &path, line.mid(colon + 2).simplified().split(' ')) {
+            const QString dependency = makefileTargetTitle(QString::fromUtf8(path));
+            if (m_outputs.contains(dependency))
+                addDependency(target, dependency);
+        }
+    }
+}
+
+QStringList CMakeAffectedTargets::targets(const QStringList &modifiedFiles) const
+{
+    QSet<QString> affected;
+    foreach (const QString &file, modifiedFiles) {
+        foreach (const QString &target, m_targetsOfFile.value(file))
+            affected.insert(target);
+    }
+
+    // Files shared between targets are only checked once
+    QHash<QString, QDateTime> lastModified;
+    foreach (const CMakeBuildTarget &target, m_targets) {
+        if (affected.contains(target.title) || target.executable.isEmpty())
+            continue;
+        const QDateTime built = QFileInfo(target.executable).lastModified();
+        if (!built.isValid()) {
+            affected.insert(target.title);
+            continue;
+        }
+        const bool changed = Utils::anyOf(target.files, [&lastModified, &built](const QString &file) {
+            auto it = lastModified.find(file);
+            if (it == lastModified.end())
+                it = lastModified.insert(file, QFileInfo(file).lastModified());
+            return *it > built;
+        });
+        if (changed)
+            affected.insert(target.title);
+    }
+
+    QStringList queue = affected.toList();
+    while (!queue.isEmpty()) {
+        foreach (const QString &dependent, m_dependents.value(queue.takeLast())) {
+            if (!affected.contains(dependent)) {
+                affected.insert(dependent);
+                queue.append(dependent);
+            }
+        }
+    }
+
+    QStringList result = affected.toList();
+    Utils::sort(result);
+    return result;
+}
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+void CMakeProjectPlugin::testCMakeAffectedTargets()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const Utils::FileName buildDirectory = Utils::FileName::fromString(dir.path() + QLatin1String("/build"));
+    auto touch = [&dir](const QString &path) {
+        QDir(dir.path()).mkpath(QFileInfo(dir.path() + QLatin1Char('/') + path).path());
+        QFile file(dir.path() + QLatin1Char('/') + path);
+        return file.open(QIODevice::WriteOnly) && file.write("x") == 1;
+    };
+    auto titles = [](const char *first, const char *second = nullptr) {
+        QStringList result(QLatin1String(first));
+        if (second)
+            result << QLatin1String(second);
+        return result;
+    };
+    auto addTarget = [&dir](QList<CMakeBuildTarget> &targets, const char *title, TargetType type,
+                            const char *output, const char *file) {
+        CMakeBuildTarget target;
+        target.title = QLatin1String(title);
+        target.targetType = type;
+        if (output)
+            target.executable = dir.path() + QLatin1String("/build/") + QLatin1String(output);
+        if (file)
+            target.files << dir.path() + QLatin1String("/src/") + QLatin1String(file);
+        targets << target;
+    };
+
+    QList<CMakeBuildTarget> targets;
+    addTarget(targets, "foo", StaticLibraryType, "lib/libfoo.a", "foo.cpp");
+    addTarget(targets, "app", ExecutableType, "bin/app", "main.cpp");
+    addTarget(targets, "tool", ExecutableType, "bin/my tool", "tool.cpp");
+    addTarget(targets, "all", UtilityType, nullptr, nullptr);
+    targets[1].files << dir.path() + QLatin1String("/src/foo.h");
+
+    // Sources first, so that every target is up to date
+    const char *files[] = {"src/foo.cpp", "src/foo.h", "src/main.cpp", "src/tool.cpp",
+                           "build/lib/libfoo.a", "build/bin/app", "build/bin/my tool"};
+    for (const char *path : files)
+        QVERIFY(touch(QLatin1String(path)));
+
+    QFile buildNinja(buildDirectory.toString() + QLatin1String("/build.ninja"));
+    QVERIFY(buildNinja.open(QIODevice::WriteOnly));
+    buildNinja.write("rule CXX_EXECUTABLE_LINKER__app\n"
+                     "  command = c++ $in -o $out\n"
+                     "build CMakeFiles/app.dir/main.cpp.o: CXX_COMPILER__app ../src/main.cpp\n"
+                     "build lib/libfoo.a: CXX_STATIC_LIBRARY_LINKER__foo CMakeFiles/foo.dir/foo.cpp.o\n"
+                     "build bin/app: CXX_EXECUTABLE_LINKER__app CMakeFiles/app.dir/main.cpp.o $\n"
+                     "    | lib/libfoo.a || foo\n"
+                     "build bin/my$ tool: CXX_EXECUTABLE_LINKER__tool CMakeFiles/tool.dir/tool.cpp.o\n"
+                     "build all: phony bin/app lib/libfoo.a bin/my$ tool\n");
+    buildNinja.close();
+
+    const QString fooSource = dir.path() + QLatin1String("/src/foo.cpp");
+    const QString appSource = dir.path() + QLatin1String("/src/main.cpp");
+    CMakeAffectedTargets affected;
+    affected.update(buildDirectory, targets);
+    QCOMPARE(affected.targets(QStringList()), QStringList());
+    QCOMPARE(affected.targets(QStringList(fooSource)), titles("app", "foo"));
+    QCOMPARE(affected.targets(QStringList(appSource)), titles("app"));
+    QCOMPARE(affected.targets(QStringList(QLatin1String("/elsewhere/main.cpp"))), QStringList());
+
+    // Never built
+    QVERIFY(QFile::remove(buildDirectory.toString() + QLatin1String("/bin/my tool")));
+    QCOMPARE(affected.targets(QStringList()), titles("tool"));
+    QVERIFY(touch(QLatin1String("build/bin/my tool")));
+
+    // The Makefile generator has the dependencies between targets in one file
+    QVERIFY(buildNinja.remove());
+    QVERIFY(QDir(buildDirectory.toString()).mkpath(QLatin1String("CMakeFiles")));
+    QFile makefile2(buildDirectory.toString() + QLatin1String("/CMakeFiles/Makefile2"));
+    QVERIFY(makefile2.open(QIODevice::WriteOnly));
+    makefile2.write("# Target rules for target CMakeFiles/tool.dir\n"
+                    "all: tools/CMakeFiles/tool.dir/all\n"
+                    "tools/CMakeFiles/tool.dir/all: CMakeFiles/foo.dir/all\n"
+                    "\t$(MAKE) -f tools/CMakeFiles/tool.dir/build.make tools/CMakeFiles/tool.dir/depend\n");
+    makefile2.close();
+    affected.update(buildDirectory, targets);
+    QCOMPARE(affected.targets(QStringList(fooSource)), titles("foo", "tool"));
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
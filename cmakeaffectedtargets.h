@@ -0,0 +1,76 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "cmakeproject.h"
+
+#include <utils/fileutils.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Finds the targets a build has to update after some files changed, so that not every
+// target of the project has to be checked by the generator.
+class CMakeAffectedTargets
+{
+public:
+    void update(const Utils::FileName &buildDirectory, const QList<CMakeBuildTarget> &targets);
+    void clear();
+
+    // The targets owning one of modifiedFiles or a file newer than their output, plus
+    // everything that depends on them. Sorted by title.
+    QStringList targets(const QStringList &modifiedFiles) const;
+
+    // The dependencies between targets as written by the generator
+    void parseNinjaDependencies(const QByteArray &buildNinja);
+    void parseMakefileDependencies(const QByteArray &makefile2);
+
+private:
+    void setTargets(const Utils::FileName &buildDirectory, const QList<CMakeBuildTarget> &targets);
+    void loadDependencies();
+    QString targetForPath(const QString &path) const;
+    void addDependency(const QString &target, const QString &dependency);
+
+    Utils::FileName m_buildDirectory;
+    QList<CMakeBuildTarget> m_targets;
+    QHash<QString, QStringList> m_targetsOfFile; // file -> titles of the targets compiling it
+    QHash<QString, QString> m_outputs; // output relative to the build directory -> title
+    QHash<QString, QSet<QString>> m_dependents; // title -> titles of the targets depending on it
+
+    Utils::FileName m_dependencyFile;
+    QDateTime m_dependencyFileLastModified;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
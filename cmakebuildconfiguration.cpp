@@ -63,6 +63,7 @@ const char CONFIGURATION_KEY[] = "CMake.Configuration";
 const char CMAKE_TOOLCHAIN_TYPE_KEY[] = "CMakeProjectManaget.CMakeBuildConfiguration.CMakeToolchainOverride";
 const char CMAKE_TOOLCHAIN_FILE_KEY[] = "CMakeProjectManaget.CMakeBuildConfiguration.CMakeToolchainFile";
 const char CMAKE_TOOLCHAIN_INLINE_KEY[] = "CMakeProjectManaget.CMakeBuildConfiguration.CMakeToolchainInline";
+const char RECONFIGURE_ON_SAVE_KEY[] = "CMakeProjectManager.CMakeBuildConfiguration.ReconfigureOnSave";
 
 CMakeBuildConfiguration::CMakeBuildConfiguration(ProjectExplorer::Target *parent) :
     BuildConfiguration(parent, Core::Id(Constants::CMAKE_BC_ID))
@@ -88,7 +89,8 @@ QString CMakeBuildConfiguration::disabledReason() const
 CMakeBuildConfiguration::CMakeBuildConfiguration(ProjectExplorer::Target *parent,
                                                  CMakeBuildConfiguration *source) :
     BuildConfiguration(parent, source),
-    m_configuration(source->m_configuration)
+    m_configuration(source->m_configuration),
+    m_reconfigureOnSave(source->m_reconfigureOnSave)
 {
     ctor();
     cloneSteps(source);
@@ -103,6 +105,7 @@ QVariantMap CMakeBuildConfiguration::toMap() const
     map.insert(QLatin1String(CMAKE_TOOLCHAIN_TYPE_KEY), static_cast<int>(m_cmakeToolchainInfo.toolchainOverride));
     map.insert(QLatin1String(CMAKE_TOOLCHAIN_FILE_KEY), m_cmakeToolchainInfo.toolchainFile);
     map.insert(QLatin1String(CMAKE_TOOLCHAIN_INLINE_KEY), m_cmakeToolchainInfo.toolchainInline);
+    map.insert(QLatin1String(RECONFIGURE_ON_SAVE_KEY), m_reconfigureOnSave);
     return map;
 }
 
@@ -141,6 +144,7 @@ bool CMakeBuildConfiguration::fromMap(const QVariantMap &map)
             map.value(QLatin1String(CMAKE_TOOLCHAIN_FILE_KEY), QLatin1String("")).toString();
     m_cmakeToolchainInfo.toolchainInline =
             map.value(QLatin1String(CMAKE_TOOLCHAIN_INLINE_KEY), QLatin1String("")).toString();
+    m_reconfigureOnSave = map.value(QLatin1String(RECONFIGURE_ON_SAVE_KEY), false).toBool();
 
     return true;
 }
@@ -188,6 +192,16 @@ bool CMakeBuildConfiguration::isParsing() const
     return m_buildDirManager && m_buildDirManager->isParsing();
 }
 
+bool CMakeBuildConfiguration::reconfigureOnSave() const
+{
+    return m_reconfigureOnSave;
+}
+
+void CMakeBuildConfiguration::setReconfigureOnSave(bool reconfigure)
+{
+    m_reconfigureOnSave = reconfigure;
+}
+
 void CMakeBuildConfiguration::resetData()
 {
     m_buildDirManager->resetData();
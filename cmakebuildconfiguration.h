@@ -78,6 +78,10 @@ public:
 
     bool isParsing() const;
 
+    // Start configuring as soon as a CMake file of the project is saved
+    bool reconfigureOnSave() const;
+    void setReconfigureOnSave(bool reconfigure);
+
     void maybeForceReparse();
     void resetData();
     bool persistCMakeState();
@@ -106,6 +110,7 @@ private:
     CMakeConfig m_configuration;
     CMakeToolchainInfo m_cmakeToolchainInfo;
     QString m_error;
+    bool m_reconfigureOnSave = false;
 
     mutable QList<CMakeConfigItem> m_completeConfigurationCache;
 
@@ -0,0 +1,475 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakebuildreport.h"
+
+#include <utils/algorithm.h>
+
+#include <QDir>
+#include <QFile>
+#include <QLoggingCategory>
+
+namespace {
+const int MAX_HISTORY = 20;
+const int TAIL_SIZE = 64;
+} // namespace
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+Utils::FileName CMakeNinjaLog::fileName(const Utils::FileName &buildDirectory)
+{
+    return Utils::FileName(buildDirectory).appendPath(QLatin1String(".ninja_log"));
+}
+
+void CMakeNinjaLog::clear()
+{
+    m_fileName.clear();
+    m_offset = 0;
+    m_tail.clear();
+    m_edges.clear();
+    m_history.clear();
+    m_linkOutputs.clear();
+    m_targets.clear();
+    m_files.clear();
+}
+
+void CMakeNinjaLog::update(const Utils::FileName &buildDirectory, const QList<CMakeBuildTarget> &targets)
+{
+    const Utils::FileName logFile = fileName(buildDirectory);
+    if (logFile != m_fileName) {
+        clear();
+        m_fileName = logFile;
+    }
+    setTargets(buildDirectory, targets);
+
+    QFile file(logFile.toString());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    // Ninja compacts its log from time to time, so the old offset is only valid as long
+    // as the bytes before it did not change. Otherwise start over, but do not count what
+    // is in the log as the last build.
+    bool incremental = m_offset > 0 && file.size() >= m_offset
+            && file.seek(m_offset - m_tail.size()) && file.read(m_tail.size()) == m_tail;
+    if (!incremental) {
+        QLoggingCategory log("qtc.cmakeprojectmanager.buildreport");
+        qCDebug(log) << "Reading" << logFile.toUserOutput() << "from the start";
+        m_offset = 0;
+        m_edges.clear();
+        file.seek(0);
+    }
+
+    const QByteArray data = file.readAll();
+    const int end = data.lastIndexOf('\n') + 1; // ninja might still be writing the last line
+    if (end == 0)
+        return;
+
+    QList<Edge> edges;
+    QList<Run> runs;
+    for (int pos = 0; pos < end; ) {
+        const int eol = data.indexOf('\n', pos);
+        const char *line = data.constData() + pos;
+        const int length = eol - pos;
+        pos = eol + 1;
+        if (length == 0 || line[0] == '#')
+            continue;
+
+        // start_ms end_ms mtime output [command hash]
+        int tabs[4];
+        int tabCount = 0;
+        for (int i = 0; i < length && tabCount < 4; ++i) {
+            if (line[i] == '\t')
+                tabs[tabCount++] = i;
+        }
+        if (tabCount < 3)
+            continue;
+        bool startOk;
+        bool endOk;
+        const qint64 startMs = QByteArray(line, tabs[0]).toLongLong(&startOk);
+        const qint64 endMs = QByteArray(line + tabs[0] + 1, tabs[1] - tabs[0] - 1).toLongLong(&endOk);
+        if (!startOk || !endOk)
+            continue;
+        const int outputEnd = tabCount == 4 ? tabs[3] : length;
+        const QString output = QString::fromUtf8(line + tabs[2] + 1, outputEnd - tabs[2] - 1);
+
+        // Edges are logged when they finish, so a smaller end time means ninja was started again
+        if (runs.isEmpty() || endMs < runs.last().endMs)
+            runs.append(Run());
+        Run &run = runs.last();
+        run.startMs = run.startMs < 0 ? startMs : qMin(run.startMs, startMs);
+        run.endMs = qMax(run.endMs, endMs);
+
+        Edge edge = classify(output);
+        edge.durationMs = endMs - startMs;
+        m_edges.insert(output, edge);
+        edges.append(edge);
+    }
+
+    m_offset += end;
+    const int tailStart = qMax(0, end - TAIL_SIZE);
+    m_tail = data.mid(tailStart, end - tailStart);
+
+    if (incremental)
+        addBuild(edges, runs);
+}
+
+void CMakeNinjaLog::setTargets(const Utils::FileName &buildDirectory,
+                               const QList<CMakeBuildTarget> &targets)
+{
+    m_linkOutputs.clear();
+    m_targets.clear();
+    m_files.clear();
+
+    const QDir buildDir(buildDirectory.toString());
+    foreach (const CMakeBuildTarget &target, targets) {
+        if (target.targetType == UtilityType)
+            continue;
+        m_targets.insert(target.title, target);
+        if (!target.executable.isEmpty())
+            m_linkOutputs.insert(buildDir.relativeFilePath(target.executable), target.title);
+        foreach (const QString &file, target.files)
+            m_files.insert(file);
+    }
+}
+
+// Maps a ninja output back to what CMake generated it from:
+//   <target dir>/CMakeFiles/<target>.dir/<source relative to the target dir>.o
+// with ".." in the relative path written as "__".
+CMakeNinjaLog::Edge CMakeNinjaLog::classify(const QString &output) const
+{
+    Edge edge;
+    edge.name = output;
+
+    const QString linkTarget = m_linkOutputs.value(output);
+    if (!linkTarget.isEmpty()) {
+        edge.kind = LinkEdge;
+        edge.name = linkTarget;
+        edge.target = linkTarget;
+        return edge;
+    }
+
+    const QLatin1String cmakeFiles("CMakeFiles/");
+    const int dirStart = output.indexOf(cmakeFiles);
+    if (dirStart < 0 || (dirStart > 0 && output.at(dirStart - 1) != QLatin1Char('/')))
+        return edge;
+    const int nameStart = dirStart + cmakeFiles.size();
+    const int nameEnd = output.indexOf(QLatin1String(".dir/"), nameStart);
+    if (nameEnd <= nameStart)
+        return edge;
+
+    QString source = output.mid(nameEnd + 5);
+    if (source.endsWith(QLatin1String(".o")))
+        source.chop(2);
+    else if (source.endsWith(QLatin1String(".obj")))
+        source.chop(4);
+    else
+        return edge;
+    source.replace(QLatin1String("__/"), QLatin1String("../"));
+
+    edge.kind = CompileEdge;
+    edge.target = output.mid(nameStart, nameEnd - nameStart);
+    edge.name = source;
+
+    const auto it = m_targets.constFind(edge.target);
+    if (it != m_targets.constEnd()) {
+        const QString inSourceDirectory = QDir::cleanPath(it->sourceDirectory + QLatin1Char('/') + source);
+        const QString absolute = QLatin1Char('/') + source; // sources outside of the source tree
+        if (m_files.contains(inSourceDirectory))
+            edge.name = inSourceDirectory;
+        else if (m_files.contains(absolute))
+            edge.name = absolute;
+    }
+    return edge;
+}
+
+void CMakeNinjaLog::addBuild(const QList<Edge> &edges, const QList<Run> &runs)
+{
+    if (edges.isEmpty())
+        return;
+
+    CMakeBuildReport::Build build;
+    build.finished = QDateTime::currentDateTime();
+    build.edges = edges.size();
+    foreach (const Run &run, runs)
+        build.wallTimeMs += run.endMs - run.startMs;
+    foreach (const Edge &edge, edges) {
+        if (edge.kind == CompileEdge)
+            build.compileTimeMs += edge.durationMs;
+        else if (edge.kind == LinkEdge)
+            build.linkTimeMs += edge.durationMs;
+    }
+
+    m_history.append(build);
+    while (m_history.size() > MAX_HISTORY)
+        m_history.removeFirst();
+}
+
+CMakeBuildReport CMakeNinjaLog::report(int maxEntries) const
+{
+    CMakeBuildReport report;
+    QHash<QString, qint64> targetTotals;
+    foreach (const Edge &edge, m_edges) {
+        CMakeBuildReport::Entry entry;
+        entry.name = edge.name;
+        entry.target = edge.target;
+        entry.durationMs = edge.durationMs;
+        if (edge.kind == CompileEdge)
+            report.compiles.append(entry);
+        else if (edge.kind == LinkEdge)
+            report.links.append(entry);
+        else
+            continue;
+        targetTotals[edge.target] += edge.durationMs;
+    }
+    for (auto it = targetTotals.constBegin(); it != targetTotals.constEnd(); ++it) {
+        CMakeBuildReport::Entry entry;
+        entry.name = it.key();
+        entry.target = it.key();
+        entry.durationMs = it.value();
+        report.targets.append(entry);
+    }
+
+    const auto slowestFirst = [](const CMakeBuildReport::Entry &a, const CMakeBuildReport::Entry &b) {
+        return a.durationMs > b.durationMs || (a.durationMs == b.durationMs && a.name < b.name);
+    };
+    foreach (QList<CMakeBuildReport::Entry> *entries,
+             QList<QList<CMakeBuildReport::Entry> *>() << &report.compiles << &report.links << &report.targets) {
+        Utils::sort(*entries, slowestFirst);
+        if (entries->size() > maxEntries)
+            entries->erase(entries->begin() + maxEntries, entries->end());
+    }
+
+    report.history = m_history;
+    return report;
+}
+
+CMakeBuildEstimate CMakeNinjaLog::estimate() const
+{
+    CMakeBuildEstimate estimate;
+    qint64 compileMs = 0;
+    int compiles = 0;
+    for (auto it = m_edges.constBegin(); it != m_edges.constEnd(); ++it) {
+        CMakeBuildEstimate::Edge edge;
+        edge.target = it->target;
+        edge.durationMs = qMax(qint64(1), it->durationMs); // every edge is some progress
+        edge.isLink = it->kind == LinkEdge;
+        estimate.m_edges.insert(it.key(), edge);
+        if (edge.isLink) {
+            estimate.m_linkMs.insert(edge.target, edge.durationMs);
+        } else {
+            compileMs += edge.durationMs;
+            ++compiles;
+        }
+    }
+    if (compiles > 0)
+        estimate.m_compileMs = qMax(qint64(1), compileMs / compiles);
+    return estimate;
+}
+
+void CMakeBuildEstimate::start()
+{
+    m_pendingLinks.clear();
+    m_linkedTargets.clear();
+    m_pendingLinkMs = 0;
+    m_doneMs = 0;
+    m_finished = 0;
+    m_total = 0;
+    m_elapsedMs = 0;
+    m_progress = 0;
+}
+
+void CMakeBuildEstimate::edgeFinished(const QString &output, int finished, int total, qint64 elapsedMs)
+{
+    m_finished = finished;
+    m_total = total;
+    m_elapsedMs = elapsedMs;
+
+    const auto it = m_edges.constFind(output);
+    if (it == m_edges.constEnd()) {
+        m_doneMs += m_compileMs;
+    } else if (it->isLink) {
+        m_doneMs += it->durationMs;
+        m_linkedTargets.insert(it->target);
+        if (m_pendingLinks.remove(it->target))
+            m_pendingLinkMs -= it->durationMs;
+    } else {
+        // Once a target compiled something, its link is one of the remaining edges
+        m_doneMs += it->durationMs;
+        const auto link = m_linkMs.constFind(it->target);
+        if (link != m_linkMs.constEnd() && !m_linkedTargets.contains(it->target)
+                && !m_pendingLinks.contains(it->target)) {
+            m_pendingLinks.insert(it->target);
+            m_pendingLinkMs += link.value();
+        }
+    }
+
+    const qint64 remaining = remainingWorkMs();
+    m_progress = qMax(m_progress, int(100 * m_doneMs / qMax(qint64(1), m_doneMs + remaining)));
+}
+
+qint64 CMakeBuildEstimate::remainingWorkMs() const
+{
+    const int remainingEdges = qMax(0, m_total - m_finished - m_pendingLinks.size());
+    return m_pendingLinkMs + remainingEdges * m_compileMs;
+}
+
+// The work done so far in the elapsed time tells how many jobs effectively run in parallel
+qint64 CMakeBuildEstimate::remainingMs() const
+{
+    if (m_finished <= 0 || m_doneMs <= 0 || m_elapsedMs <= 0)
+        return -1;
+    return remainingWorkMs() * m_elapsedMs / m_doneMs;
+}
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+void CMakeProjectPlugin::testCMakeNinjaLog()
+{
+    QTemporaryDir buildDir;
+    QVERIFY(buildDir.isValid());
+    const Utils::FileName buildDirectory = Utils::FileName::fromString(buildDir.path());
+
+    CMakeBuildTarget app;
+    app.title = QLatin1String("app");
+    app.targetType = ExecutableType;
+    app.executable = buildDir.path() + QLatin1String("/src/app");
+    app.sourceDirectory = QLatin1String("/project/src");
+    app.files << QLatin1String("/project/src/main.cpp") << QLatin1String("/project/common/util.cpp");
+    const QList<CMakeBuildTarget> targets = QList<CMakeBuildTarget>() << app;
+
+    QFile file(CMakeNinjaLog::fileName(buildDirectory).toString());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("# ninja log v5\n"
+               "0\t1200\t0\tsrc/CMakeFiles/app.dir/main.cpp.o\t1\n"
+               "10\t3000\t0\tsrc/CMakeFiles/app.dir/__/common/util.cpp.o\t2\n"
+               "3000\t3500\t0\tsrc/app\t3\n"
+               "3500\t3600\t0\tgenerated.h\t4\n"
+               "3600\t3700\t0\tsrc/CMakeFiles/app.dir/unfini");
+    file.flush();
+
+    // The existing log is not a build that was seen
+    CMakeNinjaLog log;
+    log.update(buildDirectory, targets);
+    CMakeBuildReport report = log.report(10);
+    QCOMPARE(report.compiles.size(), 2);
+    QCOMPARE(report.compiles.at(0).name, QString::fromLatin1("/project/common/util.cpp"));
+    QCOMPARE(report.compiles.at(0).target, QString::fromLatin1("app"));
+    QCOMPARE(report.compiles.at(0).durationMs, qint64(2990));
+    QCOMPARE(report.compiles.at(1).name, QString::fromLatin1("/project/src/main.cpp"));
+    QCOMPARE(report.links.size(), 1);
+    QCOMPARE(report.links.at(0).name, QString::fromLatin1("app"));
+    QCOMPARE(report.targets.size(), 1);
+    QCOMPARE(report.targets.at(0).durationMs, qint64(1200 + 2990 + 500));
+    QVERIFY(report.history.isEmpty());
+
+    // Two ninja runs after that, including the line that was incomplete before
+    file.write("shed.cpp.o\t5\n"
+               "0\t800\t0\tsrc/CMakeFiles/app.dir/main.cpp.o\t1\n"
+               "0\t100\t0\tsrc/app\t3\n");
+    file.flush();
+    log.update(buildDirectory, targets);
+    report = log.report(10);
+    QCOMPARE(report.compiles.size(), 3);
+    QCOMPARE(report.compiles.at(1).name, QString::fromLatin1("/project/src/main.cpp"));
+    QCOMPARE(report.compiles.at(1).durationMs, qint64(800));
+    QCOMPARE(report.compiles.at(2).name, QString::fromLatin1("unfinished.cpp"));
+    QCOMPARE(report.history.size(), 1);
+    QCOMPARE(report.history.at(0).edges, 3);
+    QCOMPARE(report.history.at(0).wallTimeMs, qint64(100 + 800 + 100));
+    QCOMPARE(report.history.at(0).compileTimeMs, qint64(900));
+    QCOMPARE(report.history.at(0).linkTimeMs, qint64(100));
+
+    // Compacted by ninja: read again, keep the history
+    file.close();
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("# ninja log v5\n"
+               "0\t800\t0\tsrc/CMakeFiles/app.dir/main.cpp.o\t1\n");
+    file.close();
+    log.update(buildDirectory, targets);
+    report = log.report(10);
+    QCOMPARE(report.compiles.size(), 1);
+    QVERIFY(report.links.isEmpty());
+    QCOMPARE(report.history.size(), 1);
+}
+
+void CMakeProjectPlugin::testCMakeBuildEstimate()
+{
+    QTemporaryDir buildDir;
+    QVERIFY(buildDir.isValid());
+    const Utils::FileName buildDirectory = Utils::FileName::fromString(buildDir.path());
+
+    CMakeBuildTarget app;
+    app.title = QLatin1String("app");
+    app.targetType = ExecutableType;
+    app.executable = buildDir.path() + QLatin1String("/app");
+    app.sourceDirectory = QLatin1String("/project");
+    app.files << QLatin1String("/project/main.cpp") << QLatin1String("/project/util.cpp");
+
+    QFile file(CMakeNinjaLog::fileName(buildDirectory).toString());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("# ninja log v5\n"
+               "0\t1000\t0\tCMakeFiles/app.dir/main.cpp.o\t1\n"
+               "0\t1000\t0\tCMakeFiles/app.dir/util.cpp.o\t2\n"
+               "1000\t5000\t0\tapp\t3\n");
+    file.close();
+
+    CMakeNinjaLog log;
+    log.update(buildDirectory, QList<CMakeBuildTarget>() << app);
+    CMakeBuildEstimate estimate = log.estimate();
+    estimate.start();
+    QCOMPARE(estimate.progress(), 0);
+    QCOMPARE(estimate.remainingMs(), qint64(-1));
+
+    // One of three edges, but the link that is still to come takes longest
+    estimate.edgeFinished(QLatin1String("CMakeFiles/app.dir/main.cpp.o"), 1, 3, 1000);
+    QCOMPARE(estimate.progress(), 100 * 1000 / 6000);
+    QCOMPARE(estimate.remainingMs(), qint64(5000));
+
+    // Twice as fast as before: two compiles ran in parallel
+    estimate.edgeFinished(QLatin1String("CMakeFiles/app.dir/util.cpp.o"), 2, 3, 1000);
+    QCOMPARE(estimate.progress(), 100 * 2000 / 6000);
+    QCOMPARE(estimate.remainingMs(), qint64(2000));
+
+    estimate.edgeFinished(QLatin1String("app"), 3, 3, 5000);
+    QCOMPARE(estimate.progress(), 100);
+    QCOMPARE(estimate.remainingMs(), qint64(0));
+
+    // Without history every edge costs the same
+    estimate = CMakeNinjaLog().estimate();
+    estimate.start();
+    estimate.edgeFinished(QLatin1String("generated.h"), 1, 4, 10);
+    QCOMPARE(estimate.progress(), 25);
+    QCOMPARE(estimate.remainingMs(), qint64(30));
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,161 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "cmakeproject.h"
+
+#include <utils/fileutils.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// What the last build spent its time on, and how the recent builds compare
+class CMakeBuildReport
+{
+public:
+    class Entry
+    {
+    public:
+        QString name; // source file, target title or ninja output
+        QString target; // empty if the output does not belong to a known target
+        qint64 durationMs = 0;
+    };
+
+    class Build
+    {
+    public:
+        QDateTime finished;
+        int edges = 0;
+        qint64 wallTimeMs = 0;
+        qint64 compileTimeMs = 0;
+        qint64 linkTimeMs = 0;
+    };
+
+    bool isEmpty() const { return compiles.isEmpty() && links.isEmpty() && history.isEmpty(); }
+
+    QList<Entry> compiles; // slowest first
+    QList<Entry> links; // slowest first
+    QList<Entry> targets; // compile and link time per target, slowest first
+    QList<Build> history; // oldest first
+};
+
+// Predicts how far a ninja build is from how long its edges took in earlier builds.
+// Edge counts alone are poor predictors: a link can take as long as a hundred compiles.
+class CMakeBuildEstimate
+{
+public:
+    void start();
+    // From the status line ninja prints when an edge finished
+    void edgeFinished(const QString &output, int finished, int total, qint64 elapsedMs);
+
+    int progress() const { return m_progress; } // in percent, never decreases
+    bool hasFinishedEdges() const { return m_finished > 0; }
+    qint64 remainingMs() const; // -1 if unknown
+
+private:
+    friend class CMakeNinjaLog;
+
+    class Edge
+    {
+    public:
+        QString target;
+        qint64 durationMs = 1;
+        bool isLink = false;
+    };
+
+    qint64 remainingWorkMs() const;
+
+    QHash<QString, Edge> m_edges; // output -> duration in the last build that ran it
+    QHash<QString, qint64> m_linkMs; // target -> duration of its link
+    qint64 m_compileMs = 1; // for edges without history
+
+    // The current build
+    QSet<QString> m_pendingLinks; // targets that compiled something and did not link yet
+    QSet<QString> m_linkedTargets;
+    qint64 m_pendingLinkMs = 0;
+    qint64 m_doneMs = 0;
+    int m_finished = 0;
+    int m_total = 0;
+    qint64 m_elapsedMs = 0;
+    int m_progress = 0;
+};
+
+// Reads the .ninja_log of a build directory incrementally: only what ninja appended
+// since the last update is parsed.
+class CMakeNinjaLog
+{
+public:
+    void update(const Utils::FileName &buildDirectory, const QList<CMakeBuildTarget> &targets);
+    CMakeBuildReport report(int maxEntries) const;
+    CMakeBuildEstimate estimate() const;
+    void clear();
+
+    static Utils::FileName fileName(const Utils::FileName &buildDirectory);
+
+private:
+    enum EdgeKind { OtherEdge, CompileEdge, LinkEdge };
+
+    class Edge
+    {
+    public:
+        EdgeKind kind = OtherEdge;
+        QString name;
+        QString target;
+        qint64 durationMs = 0;
+    };
+
+    class Run
+    {
+    public:
+        qint64 startMs = -1;
+        qint64 endMs = -1;
+    };
+
+    void setTargets(const Utils::FileName &buildDirectory, const QList<CMakeBuildTarget> &targets);
+    Edge classify(const QString &output) const;
+    void addBuild(const QList<Edge> &edges, const QList<Run> &runs);
+
+    Utils::FileName m_fileName;
+    qint64 m_offset = 0;
+    QByteArray m_tail; // the bytes just before m_offset, to notice that ninja rewrote the log
+
+    QHash<QString, Edge> m_edges; // latest edge per output
+    QList<CMakeBuildReport::Build> m_history;
+
+    QHash<QString, QString> m_linkOutputs; // output relative to the build directory -> target
+    QHash<QString, CMakeBuildTarget> m_targets; // title -> target
+    QSet<QString> m_files;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
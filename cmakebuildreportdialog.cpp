@@ -0,0 +1,140 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakebuildreportdialog.h"
+
+#include "cmakebuildreport.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTabWidget>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+static QString formatDuration(qint64 ms)
+{
+    return QString::number(ms / 1000.0, 'f', 1);
+}
+
+static QTreeWidget *createTree(const QStringList &headers, QWidget *parent)
+{
+    auto tree = new QTreeWidget(parent);
+    tree->setRootIsDecorated(false);
+    tree->setUniformRowHeights(true);
+    tree->setHeaderLabels(headers);
+    tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    tree->header()->setStretchLastSection(false);
+    return tree;
+}
+
+static QTreeWidget *createEntryTree(const QList<CMakeBuildReport::Entry> &entries,
+                                    const QString &nameHeader, bool showTarget, QWidget *parent)
+{
+    QStringList headers(nameHeader);
+    if (showTarget)
+        headers << CMakeBuildReportDialog::tr("Target");
+    headers << CMakeBuildReportDialog::tr("Seconds");
+
+    QTreeWidget *tree = createTree(headers, parent);
+    foreach (const CMakeBuildReport::Entry &entry, entries) {
+        QStringList columns(entry.name);
+        if (showTarget)
+            columns << entry.target;
+        columns << formatDuration(entry.durationMs);
+        auto item = new QTreeWidgetItem(tree, columns);
+        item->setToolTip(0, entry.name);
+        item->setTextAlignment(columns.size() - 1, Qt::AlignRight);
+    }
+    return tree;
+}
+
+static QTreeWidget *createHistoryTree(const QList<CMakeBuildReport::Build> &history, QWidget *parent)
+{
+    QTreeWidget *tree = createTree(QStringList()
+                                   << CMakeBuildReportDialog::tr("Finished")
+                                   << CMakeBuildReportDialog::tr("Build Steps")
+                                   << CMakeBuildReportDialog::tr("Wall Time")
+                                   << CMakeBuildReportDialog::tr("Change")
+                                   << CMakeBuildReportDialog::tr("Compiling")
+                                   << CMakeBuildReportDialog::tr("Linking"), parent);
+
+    // Newest first, compared to the build before it
+    for (int i = history.size() - 1; i >= 0; --i) {
+        const CMakeBuildReport::Build &build = history.at(i);
+        QString change;
+        if (i > 0 && history.at(i - 1).wallTimeMs > 0) {
+            const double ratio = double(build.wallTimeMs) / history.at(i - 1).wallTimeMs;
+            change = QString::fromLatin1("%1%2%").arg(ratio >= 1 ? QLatin1String("+") : QLatin1String(""))
+                    .arg(QString::number((ratio - 1) * 100, 'f', 0));
+        }
+        auto item = new QTreeWidgetItem(tree, QStringList()
+                                        << build.finished.toString(Qt::DefaultLocaleShortDate)
+                                        << QString::number(build.edges)
+                                        << formatDuration(build.wallTimeMs)
+                                        << change
+                                        << formatDuration(build.compileTimeMs)
+                                        << formatDuration(build.linkTimeMs));
+        for (int column = 1; column < tree->columnCount(); ++column)
+            item->setTextAlignment(column, Qt::AlignRight);
+    }
+    return tree;
+}
+
+CMakeBuildReportDialog::CMakeBuildReportDialog(const CMakeBuildReport &report, QWidget *parent)
+    : QDialog(parent)
+{
+    resize(800, 600);
+    setWindowTitle(tr("CMake Build Report"));
+
+    auto layout = new QVBoxLayout(this);
+    if (report.isEmpty()) {
+        auto label = new QLabel(tr("There is no build timing information for this build directory. "
+                                   "Timing information is available after building "
+                                   "with the Ninja generator."), this);
+        label->setWordWrap(true);
+        layout->addWidget(label);
+    } else {
+        auto tabs = new QTabWidget(this);
+        tabs->addTab(createEntryTree(report.compiles, tr("Source File"), true, tabs),
+                     tr("Slowest Compiles"));
+        tabs->addTab(createEntryTree(report.links, tr("Target"), false, tabs),
+                     tr("Slowest Links"));
+        tabs->addTab(createEntryTree(report.targets, tr("Target"), false, tabs),
+                     tr("Targets"));
+        tabs->addTab(createHistoryTree(report.history, tabs), tr("Recent Builds"));
+        layout->addWidget(tabs);
+    }
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, Qt::Horizontal, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttons);
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
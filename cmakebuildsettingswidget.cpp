@@ -99,6 +99,15 @@ CMakeBuildSettingsWidget::CMakeBuildSettingsWidget(CMakeBuildConfiguration *bc)
     mainLayout->addWidget(buildDirChooser->lineEdit(), row, 1);
     mainLayout->addWidget(buildDirChooser->buttonAtIndex(0), row, 2);
 
+    ++row;
+    auto reconfigureOnSave = new QCheckBox(tr("Run CMake when a CMake file is saved"));
+    reconfigureOnSave->setToolTip(tr("Otherwise CMake runs shortly after a CMake file changed on disk."));
+    reconfigureOnSave->setChecked(bc->reconfigureOnSave());
+    connect(reconfigureOnSave, &QCheckBox::toggled, this, [this](bool checked) {
+        m_buildConfiguration->setReconfigureOnSave(checked);
+    });
+    mainLayout->addWidget(reconfigureOnSave, row, 1, 1, 2);
+
     ++row;
     mainLayout->addItem(new QSpacerItem(20, 10), row, 0);
 
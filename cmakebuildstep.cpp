@@ -25,6 +25,7 @@
 
 #include "cmakebuildstep.h"
 
+#include "builddirmanager.h"
 #include "cmakebuildconfiguration.h"
 #include "cmakekitinformation.h"
 #include "cmakeparser.h"
@@ -48,14 +49,27 @@
 #include <coreplugin/find/itemviewfind.h>
 
 #include <utils/algorithm.h>
+#include <utils/hostosinfo.h>
 #include <utils/qtcprocess.h>
 #include <utils/pathchooser.h>
+#include <utils/runextensions.h>
 
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QCheckBox>
 #include <QLineEdit>
 #include <QListWidget>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QThread>
+
+#ifdef Q_OS_UNIX
+#include <stdlib.h>
+#include <unistd.h>
+#endif
 
 using namespace CMakeProjectManager;
 using namespace CMakeProjectManager::Internal;
@@ -66,8 +80,12 @@ const char MS_ID[] = "CMakeProjectManager.MakeStep";
 const char CLEAN_KEY[] = "CMakeProjectManager.MakeStep.Clean"; // Obsolete since QtC 3.7
 const char BUILD_TARGETS_KEY[] = "CMakeProjectManager.MakeStep.BuildTargets";
 const char TOOL_ARGUMENTS_KEY[] = "CMakeProjectManager.MakeStep.AdditionalArguments";
+const char AUTOMATIC_JOB_COUNT_KEY[] = "CMakeProjectManager.MakeStep.AutomaticJobCount";
+const char JOB_MEMORY_KEY[] = "CMakeProjectManager.MakeStep.JobMemory";
 const char ADD_RUNCONFIGURATION_ARGUMENT_KEY[] = "CMakeProjectManager.MakeStep.AddRunConfigurationArgument";
 const char ADD_RUNCONFIGURATION_TEXT[] = "Current executable";
+const int PROGRESS_UPDATE_INTERVAL = 100; // ms
+const int MEMORY_SAMPLE_INTERVAL = 500; // ms
 }
 
 static bool isCurrentExecutableTarget(const QString &target)
@@ -75,6 +93,110 @@ static bool isCurrentExecutableTarget(const QString &target)
     return target == QLatin1String(ADD_RUNCONFIGURATION_TEXT);
 }
 
+// The generator would run these in parallel with the other targets, cleaning what it builds,
+// or building everything while it builds the other targets
+static bool isExclusiveTarget(const QString &target)
+{
+    return target == CMakeBuildStep::allTarget() || target == CMakeBuildStep::cleanTarget();
+}
+
+static QStringList exclusiveTargetsRemoved(const QStringList &targets)
+{
+    if (targets.count() < 2)
+        return targets;
+    const QStringList specific = Utils::filtered(targets, [](const QString &target) {
+        return !isExclusiveTarget(target);
+    });
+    return specific.isEmpty() ? targets.mid(0, 1) : specific;
+}
+
+static double loadAverage()
+{
+#ifdef Q_OS_UNIX
+    double load;
+    if (getloadavg(&load, 1) == 1)
+        return load;
+#endif
+    return 0;
+}
+
+// in kB, 0 if unknown
+static qint64 availableMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile meminfo(QLatin1String("/proc/meminfo"));
+    if (meminfo.open(QIODevice::ReadOnly)) {
+        foreach (const QByteArray &line, meminfo.readAll().split('\n')) {
+            if (line.startsWith("MemAvailable:"))
+                return line.mid(13).trimmed().split(' ').first().toLongLong();
+        }
+    }
+#endif
+    return 0;
+}
+
+#ifdef Q_OS_LINUX
+static QList<qint64> childProcesses(qint64 pid)
+{
+    QList<qint64> children;
+    const QDir tasks(QString::fromLatin1("/proc/%1/task").arg(pid));
+    foreach (const QString &task, tasks.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile file(tasks.absoluteFilePath(task + QLatin1String("/children")));
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        foreach (const QByteArray &child, file.readAll().simplified().split(' ')) {
+            if (!child.isEmpty())
+                children << child.toLongLong();
+        }
+    }
+    return children;
+}
+#endif
+
+// Resident memory of the largest build job running right now, in kB, 0 if unknown. Build jobs
+// are the processes below Qt Creator that work in the build directory and run no processes
+// themselves, like the compilers run by make and ninja, but not make and ninja. Only the
+// descendants of Qt Creator are read, in a worker thread.
+static qint64 largestBuildJobMemory(const QString &buildDirectory)
+{
+#ifdef Q_OS_LINUX
+    // The working directories of the processes have their symbolic links resolved
+    const QString buildPath = QFileInfo(buildDirectory).canonicalFilePath();
+    const QString buildPrefix = buildPath + QLatin1Char('/');
+    const qint64 pageSize = sysconf(_SC_PAGESIZE) / 1024;
+    qint64 largest = 0;
+    QList<qint64> pending = childProcesses(QCoreApplication::applicationPid());
+    for (int depth = 0; !pending.isEmpty() && depth < 32; ++depth) {
+        QList<qint64> next;
+        foreach (qint64 pid, pending) {
+            const QList<qint64> children = childProcesses(pid);
+            if (!children.isEmpty()) {
+                next << children;
+                continue;
+            }
+            const QString workingDirectory
+                    = QFile::symLinkTarget(QString::fromLatin1("/proc/%1/cwd").arg(pid));
+            if (workingDirectory != buildPath && !workingDirectory.startsWith(buildPrefix))
+                continue;
+            QFile stat(QString::fromLatin1("/proc/%1/stat").arg(pid));
+            if (!stat.open(QIODevice::ReadOnly))
+                continue;
+            // "pid (comm) state ppid ...", where comm may contain anything
+            const QByteArray line = stat.readAll();
+            const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+            if (fields.size() < 22)
+                continue;
+            largest = qMax(largest, fields.at(21).toLongLong() * pageSize);
+        }
+        pending = next;
+    }
+    return largest;
+#else
+    Q_UNUSED(buildDirectory);
+    return 0;
+#endif
+}
+
 CMakeBuildStep::CMakeBuildStep(BuildStepList *bsl) : AbstractProcessStep(bsl, Core::Id(MS_ID))
 {
     ctor(bsl);
@@ -87,20 +209,37 @@ CMakeBuildStep::CMakeBuildStep(BuildStepList *bsl, Core::Id id) : AbstractProces
 
 CMakeBuildStep::CMakeBuildStep(BuildStepList *bsl, CMakeBuildStep *bs) :
     AbstractProcessStep(bsl, bs),
-    m_buildTarget(bs->m_buildTarget),
-    m_toolArguments(bs->m_toolArguments)
+    m_buildTargets(bs->m_buildTargets),
+    m_toolArguments(bs->m_toolArguments),
+    m_automaticJobCount(bs->m_automaticJobCount),
+    m_jobMemory(bs->m_jobMemory)
 {
     ctor(bsl);
 }
 
 void CMakeBuildStep::ctor(BuildStepList *bsl)
 {
-    m_percentProgress = QRegExp(QLatin1String("^\\[\\s*(\\d*)%\\]"));
-    m_ninjaProgress = QRegExp(QLatin1String("^\\[\\s*(\\d*)/\\s*(\\d*)"));
     m_ninjaProgressString = QLatin1String("[%f/%t "); // ninja: [33/100
     //: Default display name for the cmake make step.
     setDefaultDisplayName(tr("Make"));
 
+    m_progressTimer.setSingleShot(true);
+    m_progressTimer.setInterval(PROGRESS_UPDATE_INTERVAL);
+    connect(&m_progressTimer, &QTimer::timeout, this, &CMakeBuildStep::flushProgress);
+    m_memoryTimer.setInterval(MEMORY_SAMPLE_INTERVAL);
+    connect(&m_memoryTimer, &QTimer::timeout, this, &CMakeBuildStep::sampleJobMemory);
+    connect(&m_memorySample, &QFutureWatcherBase::finished,
+            this, &CMakeBuildStep::handleJobMemorySample);
+    connect(&m_compilerCacheBefore, &QFutureWatcherBase::finished,
+            this, &CMakeBuildStep::startProcess);
+    connect(&m_processWatcher, &QFutureWatcherBase::finished,
+            this, &CMakeBuildStep::handleProcessFinished);
+    connect(&m_compilerCacheAfter, &QFutureWatcherBase::finished,
+            this, &CMakeBuildStep::reportCompilerCacheStatistics);
+    connect(&m_runWatcher, &QFutureWatcherBase::canceled, this, [this]() {
+        m_processFuture.cancel();
+    });
+
     auto bc = qobject_cast<CMakeBuildConfiguration *>(bsl->parent());
     if (!bc) {
         auto t = qobject_cast<Target *>(bsl->parent()->parent());
@@ -129,34 +268,42 @@ CMakeRunConfiguration *CMakeBuildStep::targetsActiveRunConfiguration() const
 
 void CMakeBuildStep::handleBuildTargetChanges()
 {
-    if (isCurrentExecutableTarget(m_buildTarget))
-        return; // Do not change just because a different set of build targets is there...
-    if (!static_cast<CMakeProject *>(project())->buildTargetTitles().contains(m_buildTarget))
+    const QStringList titles = static_cast<CMakeProject *>(project())->buildTargetTitles();
+    // Do not drop the current executable just because a different set of build targets is there...
+    const QStringList targets = Utils::filtered(m_buildTargets, [&titles](const QString &target) {
+        return isCurrentExecutableTarget(target) || titles.contains(target);
+    });
+    if (targets.isEmpty())
         setBuildTarget(CMakeBuildStep::allTarget());
+    else
+        setBuildTargets(targets);
     emit buildTargetsChanged();
 }
 
 QVariantMap CMakeBuildStep::toMap() const
 {
     QVariantMap map(AbstractProcessStep::toMap());
-    // Use QStringList for compatibility with old files
-    map.insert(QLatin1String(BUILD_TARGETS_KEY), QStringList(m_buildTarget));
+    map.insert(QLatin1String(BUILD_TARGETS_KEY), m_buildTargets);
     map.insert(QLatin1String(TOOL_ARGUMENTS_KEY), m_toolArguments);
+    map.insert(QLatin1String(AUTOMATIC_JOB_COUNT_KEY), m_automaticJobCount);
+    map.insert(QLatin1String(JOB_MEMORY_KEY), m_jobMemory);
     return map;
 }
 
 bool CMakeBuildStep::fromMap(const QVariantMap &map)
 {
     if (map.value(QLatin1String(CLEAN_KEY), false).toBool()) {
-        m_buildTarget = CMakeBuildStep::cleanTarget();
+        m_buildTargets = QStringList(CMakeBuildStep::cleanTarget());
     } else {
         const QStringList targetList = map.value(QLatin1String(BUILD_TARGETS_KEY)).toStringList();
         if (!targetList.isEmpty())
-            m_buildTarget = targetList.last();
+            m_buildTargets = exclusiveTargetsRemoved(targetList);
         m_toolArguments = map.value(QLatin1String(TOOL_ARGUMENTS_KEY)).toString();
     }
+    m_automaticJobCount = map.value(QLatin1String(AUTOMATIC_JOB_COUNT_KEY), true).toBool();
+    m_jobMemory = map.value(QLatin1String(JOB_MEMORY_KEY), 0).toLongLong();
     if (map.value(QLatin1String(ADD_RUNCONFIGURATION_ARGUMENT_KEY), false).toBool())
-        m_buildTarget = QLatin1String(ADD_RUNCONFIGURATION_TEXT);
+        m_buildTargets = QStringList(QLatin1String(ADD_RUNCONFIGURATION_TEXT));
 
     return BuildStep::fromMap(map);
 }
@@ -173,8 +320,10 @@ bool CMakeBuildStep::init(QList<const BuildStep *> &earlierSteps)
         canInit = false;
     }
 
+    // Building only runs "cmake --build", so a tool that is still being validated is not
+    // waited for here. Running it tells whether it works.
     CMakeTool *tool = CMakeKitInformation::cmakeTool(target()->kit());
-    if (!tool || !tool->isValid()) {
+    if (!tool || (!tool->isValidationPending() && !tool->isValid())) {
         emit addTask(Task(Task::Error,
                           QCoreApplication::translate("CMakeProjectManager::CMakeBuildStep",
                                                       "Qt Creator needs a CMake Tool set up to build. "
@@ -185,7 +334,7 @@ bool CMakeBuildStep::init(QList<const BuildStep *> &earlierSteps)
     }
 
     CMakeRunConfiguration *rc = targetsActiveRunConfiguration();
-    if (isCurrentExecutableTarget(m_buildTarget) && (!rc || rc->title().isEmpty())) {
+    if (m_buildTargets.contains(QLatin1String(ADD_RUNCONFIGURATION_TEXT)) && (!rc || rc->title().isEmpty())) {
         emit addTask(Task(Task::Error,
                           QCoreApplication::translate("ProjectExplorer::Task",
                                                       "You asked to build the current Run Configuration's build target only, "
@@ -201,9 +350,13 @@ bool CMakeBuildStep::init(QList<const BuildStep *> &earlierSteps)
         return false;
     }
 
-    QString arguments = allArguments(rc);
+    m_pendingArguments = allArguments(rc);
 
-    setIgnoreReturnValue(m_buildTarget == CMakeBuildStep::cleanTarget());
+    // Nothing writes the log before the build starts, so its history is ready for the build
+    if (bc)
+        bc->buildDirManager()->updateBuildReport();
+
+    setIgnoreReturnValue(m_buildTargets == QStringList(CMakeBuildStep::cleanTarget()));
 
     ProcessParameters *pp = processParameters();
     pp->setMacroExpander(bc->macroExpander());
@@ -214,15 +367,10 @@ bool CMakeBuildStep::init(QList<const BuildStep *> &earlierSteps)
     pp->setEnvironment(env);
     pp->setWorkingDirectory(bc->buildDirectory().toString());
     pp->setCommand(cmakeCommand());
-    pp->setArguments(arguments);
+    pp->setArguments(m_pendingArguments.takeFirst());
     pp->resolveAll();
 
-    setOutputParser(new CMakeParser);
-    appendOutputParser(new GnuMakeParser);
-    IOutputParser *parser = target()->kit()->createOutputParser();
-    if (parser)
-        appendOutputParser(parser);
-    outputParser()->setWorkingDirectory(pp->effectiveWorkingDirectory());
+    createOutputParsers();
 
     return AbstractProcessStep::init(earlierSteps);
 }
@@ -238,6 +386,14 @@ void CMakeBuildStep::run(QFutureInterface<bool> &fi)
     if (bc->persistCMakeState()) {
         emit addOutput(tr("Persisting CMake state..."), BuildStep::MessageOutput);
 
+        m_runTrigger = connect(bc, &CMakeBuildConfiguration::dataAvailable,
+                               this, [this, &fi]() { runImpl(fi); });
+        m_errorTrigger = connect(bc, &CMakeBuildConfiguration::errorOccured,
+                                 this, [this, &fi]() { reportRunResult(fi, false); });
+    } else if (bc->isParsing()) {
+        // Building while cmake rewrites the build system would have make or ninja run it again
+        emit addOutput(tr("Waiting for CMake to finish..."), BuildStep::MessageOutput);
+
         m_runTrigger = connect(bc, &CMakeBuildConfiguration::dataAvailable,
                                this, [this, &fi]() { runImpl(fi); });
         m_errorTrigger = connect(bc, &CMakeBuildConfiguration::errorOccured,
@@ -253,7 +409,61 @@ void CMakeBuildStep::runImpl(QFutureInterface<bool> &fi)
     disconnect(m_runTrigger);
     disconnect(m_errorTrigger);
 
-    AbstractProcessStep::run(fi);
+    // The build process reports to a future of its own, so that the step is only finished
+    // once the statistics of the compiler cache are printed. Before that, the output of the
+    // step is still shown.
+    m_runFuture = &fi;
+    m_runWatcher.setFuture(fi.future());
+
+    // The statistics before the build are read before the first compile starts
+    m_compilerCache = CMakeCompilerCacheKitInformation::launcher(target()->kit());
+    m_compilerCacheEnvironment = processParameters()->environment();
+    m_compilerCacheAfter.cancel();
+    if (m_compilerCache.toFileInfo().isExecutable()) {
+        const Utils::FileName launcher = m_compilerCache;
+        const Utils::Environment env = m_compilerCacheEnvironment;
+        m_compilerCacheBefore.setFuture(Utils::runAsync([launcher, env]() {
+            return CMakeCompilerCache::statistics(launcher, env);
+        }));
+    } else {
+        m_compilerCacheBefore.setFuture(QFuture<CMakeCompilerCache::Statistics>());
+        startProcess();
+    }
+}
+
+void CMakeBuildStep::startProcess()
+{
+    QTC_ASSERT(m_runFuture, return);
+    if (m_runFuture->isCanceled()) {
+        finishRun(false);
+        return;
+    }
+    m_processFuture = QFutureInterface<bool>();
+    m_processFuture.reportStarted();
+    m_processWatcher.setFuture(m_processFuture.future());
+    AbstractProcessStep::run(m_processFuture);
+}
+
+void CMakeBuildStep::finishRun(bool success)
+{
+    QTC_ASSERT(m_runFuture, return);
+    QFutureInterface<bool> *runFuture = m_runFuture;
+    m_runFuture = nullptr;
+    m_runWatcher.setFuture(QFuture<bool>());
+    reportRunResult(*runFuture, success);
+}
+
+// The chain of parsers is gone after each run of a process
+void CMakeBuildStep::createOutputParsers()
+{
+    auto cmakeParser = new CMakeParser;
+    cmakeParser->setReportWarnings(false);
+    setOutputParser(cmakeParser);
+    appendOutputParser(new GnuMakeParser);
+    IOutputParser *parser = target()->kit()->createOutputParser();
+    if (parser)
+        appendOutputParser(parser);
+    outputParser()->setWorkingDirectory(processParameters()->effectiveWorkingDirectory());
 }
 
 BuildStepConfigWidget *CMakeBuildStep::createConfigWidget()
@@ -266,27 +476,105 @@ bool CMakeBuildStep::immutable() const
     return false;
 }
 
+namespace {
+
+const QChar *skipSpaces(const QChar *c, const QChar *end)
+{
+    while (c != end && c->isSpace())
+        ++c;
+    return c;
+}
+
+// Reads the (possibly empty) number at c, value is -1 if there is none or it is too large
+const QChar *readNumber(const QChar *c, const QChar *end, int *value)
+{
+    int digits = 0;
+    int result = 0;
+    for (; c != end && c->unicode() >= '0' && c->unicode() <= '9'; ++c, ++digits) {
+        if (digits < 9)
+            result = result * 10 + (c->unicode() - '0');
+    }
+    *value = (digits > 0 && digits <= 9) ? result : -1;
+    return c;
+}
+
+} // namespace
+
+bool CMakeBuildStep::parseProgress(const QString &line, int *percent, bool *isNinja)
+{
+    *percent = -1;
+    *isNinja = false;
+
+    const QChar *c = line.constData();
+    const QChar *end = c + line.size();
+    if (c == end || *c != QLatin1Char('['))
+        return false;
+
+    int first;
+    c = readNumber(skipSpaces(c + 1, end), end, &first);
+    if (c == end)
+        return false;
+
+    if (*c == QLatin1Char('%')) { // make: [ 76%]
+        if (c + 1 == end || c[1] != QLatin1Char(']'))
+            return false;
+        *percent = first;
+        return true;
+    }
+
+    if (*c == QLatin1Char('/')) { // ninja: [33/100
+        *isNinja = true;
+        int all;
+        readNumber(skipSpaces(c + 1, end), end, &all);
+        if (first >= 0 && all > 0)
+            *percent = int(100.0 * first / all);
+        return true;
+    }
+    return false;
+}
+
+bool CMakeBuildStep::parseNinjaStatus(const QString &line, int *finished, int *total, QString *output)
+{
+    const QChar *c = line.constData();
+    const QChar *end = c + line.size();
+    if (c == end || *c != QLatin1Char('['))
+        return false;
+    c = readNumber(skipSpaces(c + 1, end), end, finished);
+    if (c == end || *c != QLatin1Char('/') || *finished < 0)
+        return false;
+    readNumber(skipSpaces(c + 1, end), end, total);
+    if (*total <= 0)
+        return false;
+
+    // CMake describes an edge by what it does with its output: "Linking CXX executable app"
+    const int descriptionStart = line.indexOf(QLatin1String("] "));
+    const int outputStart = line.lastIndexOf(QLatin1Char(' ')) + 1;
+    if (descriptionStart < 0 || outputStart < descriptionStart + 2)
+        output->clear();
+    else
+        *output = line.mid(outputStart);
+    return true;
+}
+
 void CMakeBuildStep::stdOutput(const QString &line)
 {
-    if (m_percentProgress.indexIn(line) != -1) {
+    int percent;
+    bool isNinja;
+    if (parseProgress(line, &percent, &isNinja)) {
         AbstractProcessStep::stdOutput(line);
-        bool ok = false;
-        int percent = m_percentProgress.cap(1).toInt(&ok);
-        if (ok)
-            futureInterface()->setProgressValue(percent);
-        return;
-    } else if (m_ninjaProgress.indexIn(line) != -1) {
-        AbstractProcessStep::stdOutput(line);
-        m_useNinja = true;
-        bool ok = false;
-        int done = m_ninjaProgress.cap(1).toInt(&ok);
-        if (ok) {
-            int all = m_ninjaProgress.cap(2).toInt(&ok);
-            if (ok && all != 0) {
-                int percent = 100.0 * done/all;
-                futureInterface()->setProgressValue(percent);
+        if (isNinja) {
+            m_useNinja = true;
+            int finished;
+            int total;
+            QString output;
+            if (parseNinjaStatus(line, &finished, &total, &output)) {
+                m_estimate.edgeFinished(output, finished, total, m_buildTimer.elapsed());
+                reportProgress(m_estimate.progress(), remainingTimeText(m_estimate.remainingMs()));
+                return;
             }
         }
+        if (percent >= 0)
+            reportProgress(percent);
         return;
     }
     if (m_useNinja)
@@ -295,27 +583,71 @@ void CMakeBuildStep::stdOutput(const QString &line)
         AbstractProcessStep::stdOutput(line);
 }
 
-QString CMakeBuildStep::buildTarget() const
+void CMakeBuildStep::reportProgress(int percent, const QString &text)
+{
+    // Report right away when idle, afterwards at most once per interval
+    m_pendingProgress = percent;
+    m_pendingProgressText = text;
+    if (!m_progressTimer.isActive()) {
+        flushProgress();
+        m_progressTimer.start();
+    }
+}
+
+void CMakeBuildStep::flushProgress()
+{
+    if (m_pendingProgress < 0 || (m_pendingProgress == m_reportedProgress
+                                  && m_pendingProgressText == m_reportedProgressText)) {
+        return;
+    }
+    m_reportedProgress = m_pendingProgress;
+    m_reportedProgressText = m_pendingProgressText;
+    if (m_runFuture)
+        m_runFuture->setProgressValueAndText(m_reportedProgress, m_reportedProgressText);
+}
+
+QString CMakeBuildStep::remainingTimeText(qint64 remainingMs)
 {
-    return m_buildTarget;
+    if (remainingMs < 0)
+        return QString();
+    const int seconds = int((remainingMs + 999) / 1000);
+    if (seconds < 60)
+        return tr("About %n second(s) left", 0, seconds);
+    return tr("About %n minute(s) left", 0, (seconds + 30) / 60);
+}
+
+QStringList CMakeBuildStep::buildTargets() const
+{
+    return m_buildTargets;
 }
 
 bool CMakeBuildStep::buildsBuildTarget(const QString &target) const
 {
-    return target == m_buildTarget;
+    return m_buildTargets.contains(target);
 }
 
 void CMakeBuildStep::setBuildTarget(const QString &buildTarget)
 {
-    if (m_buildTarget == buildTarget)
+    setBuildTargets(QStringList(buildTarget));
+}
+
+void CMakeBuildStep::setBuildTarget(const QString &buildTarget, bool on)
+{
+    setBuildTargets(withBuildTarget(m_buildTargets, buildTarget, on));
+}
+
+void CMakeBuildStep::setBuildTargets(const QStringList &targets)
+{
+    const QStringList buildTargets = exclusiveTargetsRemoved(targets);
+    if (m_buildTargets == buildTargets)
         return;
-    m_buildTarget = buildTarget;
+    m_buildTargets = buildTargets;
     emit targetToBuildChanged();
 }
 
 void CMakeBuildStep::clearBuildTargets()
 {
-    m_buildTarget.clear();
+    m_buildTargets.clear();
 }
 
 QString CMakeBuildStep::toolArguments() const
@@ -328,31 +660,71 @@ void CMakeBuildStep::setToolArguments(const QString &list)
     m_toolArguments = list;
 }
 
-QString CMakeBuildStep::allArguments(const CMakeRunConfiguration *rc) const
+bool CMakeBuildStep::automaticJobCount() const
+{
+    return m_automaticJobCount;
+}
+
+void CMakeBuildStep::setAutomaticJobCount(bool automatic)
+{
+    m_automaticJobCount = automatic;
+}
+
+int CMakeBuildStep::jobCount(int cpuCount, double loadAverage, qint64 availableMemory, qint64 jobMemory)
+{
+    // The load average of the last minute still contains the previous build,
+    // so other processes never take away more than half of the cores.
+    int jobs = qMax(1, cpuCount - qMin(int(loadAverage), cpuCount / 2));
+    if (availableMemory > 0 && jobMemory > 0)
+        jobs = qMin(jobs, int(qMax(qint64(1), availableMemory / jobMemory)));
+    return jobs;
+}
+
+QStringList CMakeBuildStep::allArguments(const CMakeRunConfiguration *rc) const
+{
+    const QStringList targets = Utils::transform(m_buildTargets, [rc](const QString &target) {
+        if (!isCurrentExecutableTarget(target))
+            return target;
+        if (rc)
+            return rc->title();
+        return QString(QLatin1String("<i>&lt;") + tr(ADD_RUNCONFIGURATION_TEXT) + QLatin1String("&gt;</i>"));
+    });
+    const QString generator = CMakeGeneratorKitInformation::generator(target()->kit());
+    QStringList arguments;
+    foreach (const QStringList &group, targetGroups(targets, generator))
+        arguments << buildArguments(group);
+    return arguments;
+}
+
+QString CMakeBuildStep::buildArguments(const QStringList &targets) const
 {
     QString arguments;
 
     Utils::QtcProcess::addArg(&arguments, QLatin1String("--build"));
     Utils::QtcProcess::addArg(&arguments, QLatin1String("."));
 
-    QString target;
-
-    if (isCurrentExecutableTarget(m_buildTarget)) {
-        if (rc)
-            target = rc->title();
-        else
-            target = QLatin1String("<i>&lt;") + tr(ADD_RUNCONFIGURATION_TEXT) + QLatin1String("&gt;</i>");
-    } else {
-        target = m_buildTarget;
+    // cmake --build takes a single target, the others are handed to make or ninja, which
+    // schedule all of them together: cmake --build . --target a -- b c
+    if (!targets.isEmpty()) {
+        Utils::QtcProcess::addArg(&arguments, QLatin1String("--target"));
+        Utils::QtcProcess::addArg(&arguments, targets.first());
     }
 
-    Utils::QtcProcess::addArg(&arguments, QLatin1String("--target"));
-    Utils::QtcProcess::addArg(&arguments, target);
+    // make and ninja both understand -jN, unless the user asked for a job count already
+    QStringList generatorArguments = targets.mid(1);
+    if (m_automaticJobCount
+            && usesMakeOrNinja(CMakeGeneratorKitInformation::generator(target()->kit()))
+            && !hasJobCountArgument(m_toolArguments)) {
+        const int jobs = jobCount(QThread::idealThreadCount(), loadAverage(), availableMemory(),
+                                  m_jobMemory);
+        generatorArguments.prepend(QLatin1String("-j") + QString::number(jobs));
+    }
 
-    if (!m_toolArguments.isEmpty()) {
+    if (!generatorArguments.isEmpty() || !m_toolArguments.isEmpty())
         Utils::QtcProcess::addArg(&arguments, QLatin1String("--"));
+    Utils::QtcProcess::addArgs(&arguments, generatorArguments);
+    if (!m_toolArguments.isEmpty())
         arguments += QLatin1Char(' ') + m_toolArguments;
-    }
 
     return arguments;
 }
@@ -373,6 +745,66 @@ QString CMakeBuildStep::allTarget()
     return QLatin1String("all");
 }
 
+QList<QStringList> CMakeBuildStep::targetGroups(const QStringList &targets,
+                                                const QString &generator)
+{
+    if (targets.count() < 2 || usesMakeOrNinja(generator))
+        return QList<QStringList>() << targets;
+    // msbuild, xcodebuild and nmake take other arguments after "--"
+    QList<QStringList> groups;
+    foreach (const QString &target, targets)
+        groups << QStringList(target);
+    return groups;
+}
+
+bool CMakeBuildStep::usesMakeOrNinja(const QString &generator)
+{
+    // Without a generator, CMake picks Visual Studio on Windows and Unix Makefiles elsewhere
+    if (generator.isEmpty())
+        return !Utils::HostOsInfo::isWindowsHost();
+
+    // "CodeBlocks - Ninja" names an extra generator, followed by the actual one
+    const QLatin1String separator(" - ");
+    const int separatorPos = generator.lastIndexOf(separator);
+    const QString buildGenerator = separatorPos == -1
+            ? generator : generator.mid(separatorPos + separator.size());
+    if (buildGenerator == QLatin1String("Ninja"))
+        return true;
+    // NMake, Borland and Watcom make do not run jobs in parallel
+    return buildGenerator == QLatin1String("Unix Makefiles")
+            || buildGenerator == QLatin1String("MinGW Makefiles")
+            || buildGenerator == QLatin1String("MSYS Makefiles");
+}
+
+bool CMakeBuildStep::hasJobCountArgument(const QString &arguments)
+{
+    const QRegExp jobCount(QLatin1String("-j\\d*|--jobs(=\\d*)?"));
+    foreach (const QString &argument, Utils::QtcProcess::splitArgs(arguments)) {
+        if (jobCount.exactMatch(argument))
+            return true;
+    }
+    return false;
+}
+
+QStringList CMakeBuildStep::withBuildTarget(const QStringList &targets, const QString &target,
+                                            bool on)
+{
+    if (!on) {
+        QStringList result = targets;
+        result.removeAll(target);
+        return result;
+    }
+    if (isExclusiveTarget(target))
+        return QStringList(target);
+
+    QStringList result = Utils::filtered(targets, [](const QString &t) {
+        return !isExclusiveTarget(t);
+    });
+    if (!result.contains(target))
+        result.append(target);
+    return result;
+}
+
 //
 // CMakeBuildStepConfigWidget
 //
@@ -380,6 +812,7 @@ QString CMakeBuildStep::allTarget()
 CMakeBuildStepConfigWidget::CMakeBuildStepConfigWidget(CMakeBuildStep *buildStep) :
     m_buildStep(buildStep),
     m_toolArguments(new QLineEdit),
+    m_automaticJobCount(new QCheckBox),
     m_buildTargetsList(new QListWidget)
 {
     auto fl = new QFormLayout(this);
@@ -390,6 +823,11 @@ CMakeBuildStepConfigWidget::CMakeBuildStepConfigWidget(CMakeBuildStep *buildStep
     fl->addRow(tr("Tool arguments:"), m_toolArguments);
     m_toolArguments->setText(m_buildStep->toolArguments());
 
+    m_automaticJobCount->setText(tr("Choose the number of parallel jobs from cores, load and memory"));
+    m_automaticJobCount->setToolTip(tr("Ignored when the tool arguments contain -j."));
+    m_automaticJobCount->setChecked(m_buildStep->automaticJobCount());
+    fl->addRow(tr("Parallel jobs:"), m_automaticJobCount);
+
     m_buildTargetsList->setFrameStyle(QFrame::NoFrame);
     m_buildTargetsList->setMinimumHeight(200);
 
@@ -406,6 +844,7 @@ CMakeBuildStepConfigWidget::CMakeBuildStepConfigWidget(CMakeBuildStep *buildStep
     updateDetails();
 
     connect(m_toolArguments, &QLineEdit::textEdited, this, &CMakeBuildStepConfigWidget::toolArgumentsEdited);
+    connect(m_automaticJobCount, &QCheckBox::toggled, this, &CMakeBuildStepConfigWidget::automaticJobCountToggled);
     connect(m_buildTargetsList, &QListWidget::itemChanged, this, &CMakeBuildStepConfigWidget::itemChanged);
     connect(ProjectExplorerPlugin::instance(), &ProjectExplorerPlugin::settingsChanged,
             this, &CMakeBuildStepConfigWidget::updateDetails);
@@ -422,11 +861,17 @@ void CMakeBuildStepConfigWidget::toolArgumentsEdited()
     updateDetails();
 }
 
+void CMakeBuildStepConfigWidget::automaticJobCountToggled(bool automatic)
+{
+    m_buildStep->setAutomaticJobCount(automatic);
+    updateDetails();
+}
+
 void CMakeBuildStepConfigWidget::itemChanged(QListWidgetItem *item)
 {
-    const QString target =
-            (item->checkState() == Qt::Checked) ? item->data(Qt::UserRole).toString() : CMakeBuildStep::allTarget();
-    m_buildStep->setBuildTarget(target);
+    m_buildStep->setBuildTarget(item->data(Qt::UserRole).toString(), item->checkState() == Qt::Checked);
+    if (m_buildStep->buildTargets().isEmpty())
+        m_buildStep->setBuildTarget(CMakeBuildStep::allTarget());
     updateDetails();
 }
 
@@ -494,8 +939,13 @@ void CMakeBuildStepConfigWidget::updateDetails()
     param.setEnvironment(bc->environment());
     param.setWorkingDirectory(bc->buildDirectory().toString());
     param.setCommand(m_buildStep->cmakeCommand());
-    param.setArguments(m_buildStep->allArguments(0));
-    m_summaryText = param.summary(displayName());
+    m_summaryText.clear();
+    foreach (const QString &arguments, m_buildStep->allArguments(0)) {
+        param.setArguments(arguments);
+        if (!m_summaryText.isEmpty())
+            m_summaryText += QLatin1String("<br>");
+        m_summaryText += param.summary(displayName());
+    }
 
     emit updateSummary();
 }
@@ -581,12 +1031,350 @@ QList<ProjectExplorer::BuildStepInfo> CMakeBuildStepFactory::availableSteps(Proj
 void CMakeBuildStep::processStarted()
 {
     m_useNinja = false;
-    futureInterface()->setProgressRange(0, 100);
+    m_reportedProgress = -1;
+    m_pendingProgress = -1;
+    m_reportedProgressText.clear();
+    m_pendingProgressText.clear();
+    m_runFuture->setProgressRange(0, 100);
+
+    if (CMakeBuildConfiguration *bc = cmakeBuildConfiguration()) {
+        BuildDirManager *bdm = bc->buildDirManager();
+        m_estimate = bdm->buildEstimate();
+        // The history arrives late if the log was still being read, which is of use until
+        // the first edge finished
+        m_estimateTrigger = connect(bdm, &BuildDirManager::buildEstimateAvailable,
+                                    this, [this, bdm]() {
+                                        if (m_estimate.hasFinishedEdges())
+                                            return;
+                                        m_estimate = bdm->buildEstimate();
+                                        m_estimate.start();
+                                    });
+    }
+    m_estimate.start();
+    m_buildTimer.start();
+
+    m_buildJobMemory = 0;
+    m_memoryTimer.start();
+
     AbstractProcessStep::processStarted();
 }
 
 void CMakeBuildStep::processFinished(int exitCode, QProcess::ExitStatus status)
 {
+    m_progressTimer.stop();
+    m_pendingProgress = -1;
+    disconnect(m_estimateTrigger);
+    m_estimate = CMakeBuildEstimate();
     AbstractProcessStep::processFinished(exitCode, status);
-    futureInterface()->setProgressValue(100);
+    m_runFuture->setProgressValueAndText(100, QString());
+
+    // The jobs are gone by now, so the samples taken while they ran are all there is
+    m_memoryTimer.stop();
+    m_jobMemory = updatedJobMemory(m_jobMemory, m_buildJobMemory);
+
+    if (CMakeBuildConfiguration *bc = cmakeBuildConfiguration())
+        bc->buildDirManager()->updateBuildReport();
+}
+
+void CMakeBuildStep::sampleJobMemory()
+{
+    if (m_memorySample.isRunning())
+        return;
+    const QString buildDirectory = processParameters()->effectiveWorkingDirectory();
+    m_memorySample.setFuture(Utils::runAsync([buildDirectory]() {
+        return largestBuildJobMemory(buildDirectory);
+    }));
+}
+
+void CMakeBuildStep::handleJobMemorySample()
+{
+    // Samples that arrive after the build are late for it
+    if (m_memoryTimer.isActive() && m_memorySample.future().resultCount() > 0)
+        m_buildJobMemory = qMax(m_buildJobMemory, m_memorySample.result());
+}
+
+qint64 CMakeBuildStep::updatedJobMemory(qint64 jobMemory, qint64 buildJobMemory)
+{
+    // Builds without jobs, like those with nothing to do, say nothing about the jobs
+    if (buildJobMemory <= 0)
+        return jobMemory;
+    // Too few jobs would run if the estimate was too low, so it follows growth immediately,
+    // while it shrinks slowly, as the build may just not have built the largest files
+    if (buildJobMemory >= jobMemory)
+        return buildJobMemory;
+    return (3 * jobMemory + buildJobMemory) / 4;
+}
+
+void CMakeBuildStep::handleProcessFinished()
+{
+    m_processSucceeded = m_processFuture.resultCount() > 0 && m_processFuture.future().result();
+    // Generators other than make and ninja build one target per run of cmake --build
+    if (m_processSucceeded && !m_processFuture.isCanceled() && !m_pendingArguments.isEmpty()) {
+        processParameters()->setArguments(m_pendingArguments.takeFirst());
+        processParameters()->resolveAll();
+        createOutputParsers();
+        startProcess();
+        return;
+    }
+    m_pendingArguments.clear();
+    startCompilerCacheStatistics();
+}
+
+void CMakeBuildStep::startCompilerCacheStatistics()
+{
+    if (m_processFuture.isCanceled() || m_compilerCacheBefore.isCanceled()
+            || m_compilerCacheBefore.future().resultCount() == 0
+            || !m_compilerCacheBefore.result().isValid()) {
+        finishRun(m_processSucceeded);
+        return;
+    }
+    const Utils::FileName launcher = m_compilerCache;
+    const Utils::Environment env = m_compilerCacheEnvironment;
+    m_compilerCacheAfter.setFuture(Utils::runAsync([launcher, env]() {
+        return CMakeCompilerCache::statistics(launcher, env);
+    }));
+}
+
+// The statistics of the cache are global, so compiles of other builds running
+// at the same time are included
+void CMakeBuildStep::reportCompilerCacheStatistics()
+{
+    if (m_compilerCacheAfter.isCanceled() || m_compilerCacheAfter.future().resultCount() == 0)
+        return;
+    const CMakeCompilerCache::Statistics statistics
+            = m_compilerCacheAfter.result() - m_compilerCacheBefore.result();
+    if (statistics.isValid() && statistics.hits + statistics.misses > 0) {
+        const qint64 total = statistics.hits + statistics.misses;
+        emit addOutput(tr("Compiler cache %1: %2 hits, %3 misses (%4% hit rate)")
+                       .arg(m_compilerCache.fileName())
+                       .arg(statistics.hits).arg(statistics.misses)
+                       .arg(statistics.hits * 100 / total),
+                       BuildStep::MessageOutput);
+    }
+    finishRun(m_processSucceeded);
+}
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QRegExp>
+#include <QTest>
+
+void CMakeProjectPlugin::testCMakeBuildStepProgress_data()
+{
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<bool>("isProgress");
+    QTest::addColumn<int>("percent");
+    QTest::addColumn<bool>("isNinja");
+
+    QTest::newRow("make") << QString::fromLatin1("[ 76%] Building CXX object foo.o") << true << 76 << false;
+    QTest::newRow("make 100") << QString::fromLatin1("[100%] Built target foo") << true << 100 << false;
+    QTest::newRow("make no spaces") << QString::fromLatin1("[5%]") << true << 5 << false;
+    QTest::newRow("make no number") << QString::fromLatin1("[ %] x") << true << -1 << false;
+    QTest::newRow("make unterminated") << QString::fromLatin1("[ 76% x") << false << -1 << false;
+    QTest::newRow("ninja") << QString::fromLatin1("[33/100 12.5/sec] Building CXX object foo.o") << true << 33 << true;
+    QTest::newRow("ninja spaces") << QString::fromLatin1("[  1/  3 ") << true << 33 << true;
+    QTest::newRow("ninja no total") << QString::fromLatin1("[1/") << true << -1 << true;
+    QTest::newRow("ninja zero total") << QString::fromLatin1("[0/0 ") << true << -1 << true;
+    QTest::newRow("leading space") << QString::fromLatin1(" [ 76%]") << false << -1 << false;
+    QTest::newRow("compiler output") << QString::fromLatin1("foo.cpp:12:3: warning: unused variable") << false << -1 << false;
+    QTest::newRow("bracket text") << QString::fromLatin1("[ERROR] something") << false << -1 << false;
+    QTest::newRow("empty") << QString() << false << -1 << false;
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepProgress()
+{
+    QFETCH(QString, line);
+    QFETCH(bool, isProgress);
+    QFETCH(int, percent);
+    QFETCH(bool, isNinja);
+
+    int actualPercent;
+    bool actualIsNinja;
+    QCOMPARE(CMakeBuildStep::parseProgress(line, &actualPercent, &actualIsNinja), isProgress);
+    QCOMPARE(actualPercent, percent);
+    QCOMPARE(actualIsNinja, isNinja);
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepNinjaStatus()
+{
+    int finished;
+    int total;
+    QString output;
+    QVERIFY(CMakeBuildStep::parseNinjaStatus(
+                QString::fromLatin1("[33/100 12.5/sec] Building CXX object CMakeFiles/app.dir/main.cpp.o"),
+                &finished, &total, &output));
+    QCOMPARE(finished, 33);
+    QCOMPARE(total, 100);
+    QCOMPARE(output, QString::fromLatin1("CMakeFiles/app.dir/main.cpp.o"));
+
+    QVERIFY(CMakeBuildStep::parseNinjaStatus(QString::fromLatin1("[  1/  3 0.0/sec] app"),
+                                             &finished, &total, &output));
+    QCOMPARE(output, QString::fromLatin1("app"));
+    QVERIFY(CMakeBuildStep::parseNinjaStatus(QString::fromLatin1("[1/3 "), &finished, &total, &output));
+    QVERIFY(output.isEmpty());
+
+    QVERIFY(!CMakeBuildStep::parseNinjaStatus(QString::fromLatin1("[0/0 ] x"), &finished, &total, &output));
+    QVERIFY(!CMakeBuildStep::parseNinjaStatus(QString::fromLatin1("[ 76%] x"), &finished, &total, &output));
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepJobCount_data()
+{
+    QTest::addColumn<int>("cpuCount");
+    QTest::addColumn<double>("loadAverage");
+    QTest::addColumn<qint64>("availableMemory");
+    QTest::addColumn<qint64>("jobMemory");
+    QTest::addColumn<int>("jobs");
+
+    QTest::newRow("idle") << 8 << 0.3 << qint64(0) << qint64(0) << 8;
+    QTest::newRow("busy") << 8 << 2.7 << qint64(0) << qint64(0) << 6;
+    QTest::newRow("very busy") << 8 << 20.0 << qint64(0) << qint64(0) << 4;
+    QTest::newRow("single core") << 1 << 3.0 << qint64(0) << qint64(0) << 1;
+    QTest::newRow("memory") << 16 << 0.0 << qint64(8000000) << qint64(2000000) << 4;
+    QTest::newRow("plenty of memory") << 4 << 0.0 << qint64(64000000) << qint64(500000) << 4;
+    QTest::newRow("out of memory") << 4 << 0.0 << qint64(100000) << qint64(2000000) << 1;
+    QTest::newRow("memory unknown") << 4 << 0.0 << qint64(0) << qint64(2000000) << 4;
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepJobCount()
+{
+    QFETCH(int, cpuCount);
+    QFETCH(double, loadAverage);
+    QFETCH(qint64, availableMemory);
+    QFETCH(qint64, jobMemory);
+    QFETCH(int, jobs);
+
+    QCOMPARE(CMakeBuildStep::jobCount(cpuCount, loadAverage, availableMemory, jobMemory), jobs);
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepJobMemory()
+{
+    QCOMPARE(CMakeBuildStep::updatedJobMemory(0, 0), qint64(0));
+    QCOMPARE(CMakeBuildStep::updatedJobMemory(0, 500000), qint64(500000));
+    QCOMPARE(CMakeBuildStep::updatedJobMemory(500000, 0), qint64(500000));
+    QCOMPARE(CMakeBuildStep::updatedJobMemory(500000, 800000), qint64(800000));
+    QCOMPARE(CMakeBuildStep::updatedJobMemory(800000, 400000), qint64(700000));
+
+    qint64 jobMemory = 2000000;
+    for (int i = 0; i < 20; ++i)
+        jobMemory = CMakeBuildStep::updatedJobMemory(jobMemory, 100000);
+    QVERIFY(jobMemory < 110000);
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepJobCountArgument()
+{
+    QVERIFY(CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("Ninja")));
+    QVERIFY(CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("Unix Makefiles")));
+    QVERIFY(CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("CodeBlocks - Ninja")));
+    QVERIFY(CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("CodeBlocks - MinGW Makefiles")));
+    QVERIFY(!CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("NMake Makefiles")));
+    QVERIFY(!CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("Visual Studio 14 2015")));
+    QVERIFY(!CMakeBuildStep::usesMakeOrNinja(QString::fromLatin1("Xcode")));
+
+    QVERIFY(CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("-j4")));
+    QVERIFY(CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("-k -j 4")));
+    QVERIFY(CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("--jobs=2")));
+    QVERIFY(CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("--jobs")));
+    QVERIFY(!CMakeBuildStep::hasJobCountArgument(QString()));
+    QVERIFY(!CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("-jobs")));
+    QVERIFY(!CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("--just-print")));
+    QVERIFY(!CMakeBuildStep::hasJobCountArgument(QString::fromLatin1("VERBOSE=-j4x")));
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepTargetGroups()
+{
+    const QStringList targets = QStringList() << QString::fromLatin1("app")
+                                              << QString::fromLatin1("lib");
+    const QList<QStringList> together = QList<QStringList>() << targets;
+    const QList<QStringList> separate = QList<QStringList>()
+            << QStringList(targets.at(0)) << QStringList(targets.at(1));
+
+    QCOMPARE(CMakeBuildStep::targetGroups(targets, QString::fromLatin1("Ninja")), together);
+    QCOMPARE(CMakeBuildStep::targetGroups(targets, QString::fromLatin1("Unix Makefiles")), together);
+    QCOMPARE(CMakeBuildStep::targetGroups(targets, QString::fromLatin1("Visual Studio 14 2015")),
+             separate);
+    QCOMPARE(CMakeBuildStep::targetGroups(targets, QString::fromLatin1("Xcode")), separate);
+    QCOMPARE(CMakeBuildStep::targetGroups(targets, QString::fromLatin1("NMake Makefiles")), separate);
+    QCOMPARE(CMakeBuildStep::targetGroups(QStringList(targets.at(0)), QString::fromLatin1("Xcode")),
+             QList<QStringList>() << QStringList(targets.at(0)));
+    QCOMPARE(CMakeBuildStep::targetGroups(QStringList(), QString::fromLatin1("Xcode")),
+             QList<QStringList>() << QStringList());
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepExclusiveTargets()
+{
+    const QString all = CMakeBuildStep::allTarget();
+    const QString clean = CMakeBuildStep::cleanTarget();
+    const QString app = QString::fromLatin1("app");
+    const QString lib = QString::fromLatin1("lib");
+
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList(all), app, true), QStringList(app));
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList(clean), app, true), QStringList(app));
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList(app), lib, true),
+             QStringList() << app << lib);
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList() << app << lib, all, true),
+             QStringList(all));
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList() << app << lib, clean, true),
+             QStringList(clean));
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList(all), clean, true), QStringList(clean));
+    QCOMPARE(CMakeBuildStep::withBuildTarget(QStringList() << app << lib, app, false),
+             QStringList(lib));
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepProgressBenchmark_data()
+{
+    QTest::addColumn<bool>("useScanner");
+
+    QTest::newRow("QRegExp") << false;
+    QTest::newRow("parseProgress") << true;
+}
+
+void CMakeProjectPlugin::testCMakeBuildStepProgressBenchmark()
+{
+    QFETCH(bool, useScanner);
+
+    // A ninja build log of 200k lines, with a warning after every tenth build statement
+    const int lineCount = 200000;
+    const int statements = lineCount * 10 / 11;
+    int progressLineCount = 0;
+    QStringList log;
+    log.reserve(lineCount);
+    for (int i = 1; log.size() < lineCount; ++i, ++progressLineCount) {
+        log << QString::fromLatin1("[%1/%2 312.4/sec] Building CXX object src/module%3/CMakeFiles/"
+                                   "module%3.dir/file%1.cpp.o").arg(i).arg(statements).arg(i % 100);
+        if (i % 10 == 0) {
+            log << QString::fromLatin1("/home/user/project/src/module%1/file%2.cpp:42:13: warning: "
+                                       "unused variable 'x' [-Wunused-variable]").arg(i % 100).arg(i);
+        }
+    }
+
+    int progressLines = 0;
+    if (useScanner) {
+        QBENCHMARK {
+            progressLines = 0;
+            foreach (const QString &line, log) {
+                int percent;
+                bool isNinja;
+                if (CMakeBuildStep::parseProgress(line, &percent, &isNinja))
+                    ++progressLines;
+            }
+        }
+    } else {
+        // What stdOutput did before
+        QRegExp percentProgress(QLatin1String("^\\[\\s*(\\d*)%\\]"));
+        QRegExp ninjaProgress(QLatin1String("^\\[\\s*(\\d*)/\\s*(\\d*)"));
+        QBENCHMARK {
+            progressLines = 0;
+            foreach (const QString &line, log) {
+                if (percentProgress.indexIn(line) != -1 || ninjaProgress.indexIn(line) != -1) {
+                    ninjaProgress.cap(1).toInt();
+                    ninjaProgress.cap(2).toInt();
+                    ++progressLines;
+                }
+            }
+        }
+    }
+    QCOMPARE(progressLines, progressLineCount);
 }
+
+#endif
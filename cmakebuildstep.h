@@ -25,10 +25,18 @@
 
 #pragma once
 
+#include "cmakebuildreport.h"
+#include "cmakecompilercache.h"
+
 #include <projectexplorer/abstractprocessstep.h>
 #include <projectexplorer/buildstep.h>
 
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QTimer>
+
 QT_BEGIN_NAMESPACE
+class QCheckBox;
 class QLineEdit;
 class QListWidget;
 class QListWidgetItem;
@@ -62,15 +70,21 @@ public:
     ProjectExplorer::BuildStepConfigWidget *createConfigWidget() override;
     bool immutable() const override;
 
-    QString buildTarget() const;
+    QStringList buildTargets() const;
     bool buildsBuildTarget(const QString &target) const;
-    void setBuildTarget(const QString &target);
+    void setBuildTarget(const QString &target); // builds only target
+    void setBuildTarget(const QString &target, bool on);
+    void setBuildTargets(const QStringList &targets);
     void clearBuildTargets();
 
     QString toolArguments() const;
     void setToolArguments(const QString &list);
 
-    QString allArguments(const CMakeRunConfiguration *rc) const;
+    bool automaticJobCount() const;
+    void setAutomaticJobCount(bool automatic);
+
+    // The arguments of each run of "cmake --build" the step does
+    QStringList allArguments(const CMakeRunConfiguration *rc) const;
 
     QString cmakeCommand() const;
 
@@ -79,6 +93,33 @@ public:
     static QString cleanTarget();
     static QString allTarget();
 
+    // "all" and "clean" are only built on their own: Checking them unchecks the other
+    // targets, and checking another target unchecks them.
+    static QStringList withBuildTarget(const QStringList &targets, const QString &target, bool on);
+
+    // Recognizes the "[ 76%]" prefix of make and the "[33/100" prefix of ninja.
+    // percent is -1 if the line does not say how far the build is.
+    static bool parseProgress(const QString &line, int *percent, bool *isNinja);
+
+    // Splits the "[33/100 2.5/sec] Building CXX object <output>" status line of ninja
+    static bool parseNinjaStatus(const QString &line, int *finished, int *total, QString *output);
+
+    // One job per core, minus the cores other processes keep busy, and no more jobs than
+    // fit into the available memory when a job needs jobMemory (both in kB, 0 if unknown).
+    static int jobCount(int cpuCount, double loadAverage, qint64 availableMemory, qint64 jobMemory);
+
+    // The estimate of the memory a build job needs after a build whose largest job needed
+    // buildJobMemory (both in kB, 0 if unknown)
+    static qint64 updatedJobMemory(qint64 jobMemory, qint64 buildJobMemory);
+
+    // Whether the build tool of the generator is make or ninja, which take -jN as well as
+    // further targets after "--"
+    static bool usesMakeOrNinja(const QString &generator);
+    // The targets built by each run of "cmake --build"
+    static QList<QStringList> targetGroups(const QStringList &targets, const QString &generator);
+    // Whether the arguments for the build tool already set a job count
+    static bool hasJobCountArgument(const QString &arguments);
+
 signals:
     void cmakeCommandChanged();
     void targetToBuildChanged();
@@ -100,18 +141,53 @@ private:
     void ctor(ProjectExplorer::BuildStepList *bsl);
 
     void runImpl(QFutureInterface<bool> &fi);
+    void startProcess();
+    void createOutputParsers();
+    QString buildArguments(const QStringList &targets) const;
+    void handleProcessFinished();
+    void finishRun(bool success);
 
     void handleBuildTargetChanges();
     CMakeRunConfiguration *targetsActiveRunConfiguration() const;
 
+    void reportProgress(int percent, const QString &text = QString());
+    static QString remainingTimeText(qint64 remainingMs);
+    void flushProgress();
+    void startCompilerCacheStatistics();
+    void reportCompilerCacheStatistics();
+    void sampleJobMemory();
+    void handleJobMemorySample();
+
     QMetaObject::Connection m_runTrigger;
     QMetaObject::Connection m_errorTrigger;
+    QMetaObject::Connection m_estimateTrigger;
 
-    QRegExp m_percentProgress;
-    QRegExp m_ninjaProgress;
     QString m_ninjaProgressString;
-    QString m_buildTarget;
+    QTimer m_progressTimer; // coalesces progress updates of fast builds
+    int m_reportedProgress = -1;
+    int m_pendingProgress = -1;
+    QString m_reportedProgressText;
+    QString m_pendingProgressText;
+    CMakeBuildEstimate m_estimate; // weighs the edges of ninja builds by their history
+    QElapsedTimer m_buildTimer;
+    QStringList m_buildTargets; // built by one generator run
     QString m_toolArguments;
+    bool m_automaticJobCount = true;
+    qint64 m_jobMemory = 0; // peak memory of a build job in kB, learned from past builds
+    qint64 m_buildJobMemory = 0; // peak memory of a job of the running build in kB
+    QTimer m_memoryTimer;
+    QFutureWatcher<qint64> m_memorySample; // reads /proc in a worker thread
+    Utils::FileName m_compilerCache;
+    Utils::Environment m_compilerCacheEnvironment;
+    // Asking the cache may take a while, so it happens in worker threads
+    QFutureWatcher<CMakeCompilerCache::Statistics> m_compilerCacheBefore;
+    QFutureWatcher<CMakeCompilerCache::Statistics> m_compilerCacheAfter;
+    QFutureInterface<bool> *m_runFuture = nullptr; // of the step, finished after the statistics
+    QFutureWatcher<bool> m_runWatcher; // forwards canceling the step to the process
+    QFutureInterface<bool> m_processFuture; // of the build process
+    QFutureWatcher<bool> m_processWatcher;
+    bool m_processSucceeded = false;
+    QStringList m_pendingArguments; // of the runs of cmake --build that are still to come
     bool m_useNinja = false;
 };
 
@@ -126,12 +202,14 @@ public:
 private:
     void itemChanged(QListWidgetItem*);
     void toolArgumentsEdited();
+    void automaticJobCountToggled(bool automatic);
     void updateDetails();
     void buildTargetsChanged();
     void selectedBuildTargetsChanged();
 
     CMakeBuildStep *m_buildStep;
     QLineEdit *m_toolArguments;
+    QCheckBox *m_automaticJobCount;
     QListWidget *m_buildTargetsList;
     QString m_summaryText;
 };
@@ -32,7 +32,12 @@
 #include <utils/algorithm.h>
 #include <projectexplorer/projectnodes.h>
 
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QLoggingCategory>
+#include <QTextStream>
+#include <QtConcurrent>
 
 using namespace ProjectExplorer;
 using namespace Utils;
@@ -45,12 +50,187 @@ namespace Internal {
 ////
 
 namespace {
-int distance(const QString &targetDirectory, const FileName &fileName)
+
+struct DirectoryInformationRequest
+{
+    QString workingDirectory;
+    QDateTime cachedLastModified;
+};
+
+struct DirectoryInformationResult
+{
+    QString workingDirectory;
+    QDateTime lastModified;
+    QString sourceDirectory;
+    bool upToDate = false;
+};
+
+DirectoryInformationResult readDirectoryInformation(const DirectoryInformationRequest &request)
+{
+    DirectoryInformationResult result;
+    result.workingDirectory = request.workingDirectory;
+
+    QFile cmakeSourceInfoFile(request.workingDirectory
+                              + QStringLiteral("/CMakeFiles/CMakeDirectoryInformation.cmake"));
+    const QFileInfo fi(cmakeSourceInfoFile.fileName());
+    result.lastModified = fi.lastModified();
+    if (fi.exists() && result.lastModified == request.cachedLastModified) {
+        result.upToDate = true;
+        return result;
+    }
+
+    if (cmakeSourceInfoFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&cmakeSourceInfoFile);
+        const QLatin1String searchSource("SET(CMAKE_RELATIVE_PATH_TOP_SOURCE \"");
+        while (!stream.atEnd()) {
+            const QString lineTopSource = stream.readLine().trimmed();
+            if (lineTopSource.startsWith(searchSource, Qt::CaseInsensitive)) {
+                result.sourceDirectory = lineTopSource.mid(searchSource.size());
+                result.sourceDirectory.chop(2); // cut off ")
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+QHash<QString, QString> CMakeDirectoryInformationCache::sourceDirectories(const QStringList &workingDirectories)
+{
+    QList<DirectoryInformationRequest> requests;
+    foreach (const QString &workingDirectory, workingDirectories) {
+        DirectoryInformationRequest request;
+        request.workingDirectory = workingDirectory;
+        request.cachedLastModified = m_entries.value(workingDirectory).lastModified;
+        requests.append(request);
+    }
+
+    const QList<DirectoryInformationResult> results
+            = QtConcurrent::blockingMapped(requests, readDirectoryInformation);
+
+    QHash<QString, QString> sourceDirectories;
+    foreach (const DirectoryInformationResult &r, results) {
+        if (!r.upToDate) {
+            Entry entry;
+            entry.lastModified = r.lastModified;
+            entry.sourceDirectory = r.sourceDirectory;
+            m_entries.insert(r.workingDirectory, entry);
+        }
+        sourceDirectories.insert(r.workingDirectory, m_entries.value(r.workingDirectory).sourceDirectory);
+    }
+    return sourceDirectories;
+}
+
+// Every directory that contains the source directory of a target is a node. For a file, each
+// of its parent directories A in the tree is a candidate common directory with the targets
+// below A, at a distance of depth(target) - 2 * depth(A) + depth(file). The best target below
+// A is precomputed, so a file needs one lookup per path component.
+//
+// This matches how distances were computed before by comparing paths with Utils::commonPath:
+// If a target directory contains the file, the common path of both is the parent directory
+// of the target, and the root directory "/" has a depth of one.
+CMakeTargetDirectoryIndex::CMakeTargetDirectoryIndex(const QList<CMakeBuildTarget> &targets)
+{
+    m_nodes.append(Node()); // Paths without any common directory, like "C:/a" and "D:/b"
+
+    for (int i = 0; i < targets.size(); ++i) {
+        const CMakeBuildTarget &target = targets.at(i);
+        if (!m_titles.contains(target.title))
+            m_titles.insert(target.title, i);
+        m_targetDepths.append(target.sourceDirectory.count(QLatin1Char('/')));
+        m_targetIncludeCounts.append(target.includeFiles.count());
+        if (target.includeFiles.isEmpty())
+            continue;
+
+        int node = 0;
+        int depth = 0;
+        foreach (const QString &component, target.sourceDirectory.split(QLatin1Char('/'))) {
+            int child = m_nodes.at(node).children.value(component, -1);
+            if (child == -1) {
+                child = m_nodes.size();
+                Node childNode;
+                childNode.depth = (node == 0 && component.isEmpty()) ? 1 : depth;
+                m_nodes.append(childNode);
+                m_nodes[node].children.insert(component, child);
+            }
+            node = child;
+            ++depth;
+        }
+        if (isBetter(i, m_nodes.at(node).ownBest))
+            m_nodes[node].ownBest = i;
+    }
+
+    computeBest(0);
+}
+
+int CMakeTargetDirectoryIndex::bestTarget(const FileName &fileName) const
+{
+    int best = -1;
+    int bestValue = 0;
+    auto consider = [this, &best, &bestValue](int node) {
+        const int target = m_nodes.at(node).descendantBest;
+        if (target == -1)
+            return;
+        const int value = m_targetDepths.at(target) - 2 * m_nodes.at(node).depth;
+        if (value == bestValue && best != -1) {
+            // Same distance: Prefer more include paths, then the earlier target
+            const int includeCount = m_targetIncludeCounts.at(target);
+            const int bestIncludeCount = m_targetIncludeCounts.at(best);
+            if (includeCount > bestIncludeCount || (includeCount == bestIncludeCount && target < best))
+                best = target;
+        } else if (best == -1 || value < bestValue) {
+            best = target;
+            bestValue = value;
+        }
+    };
+
+    consider(0);
+    const QVector<QStringRef> components = fileName.toString().splitRef(QLatin1Char('/'));
+    int node = 0;
+    for (int i = 0; i < components.size() - 1; ++i) { // The last component is the file name
+        node = m_nodes.at(node).children.value(components.at(i).toString(), -1);
+        if (node == -1)
+            break;
+        consider(node);
+    }
+    return best;
+}
+
+int CMakeTargetDirectoryIndex::targetForTitle(const QString &title) const
 {
-    const QString commonParent = Utils::commonPath(QStringList() << targetDirectory << fileName.toString());
-    return targetDirectory.mid(commonParent.size()).count(QLatin1Char('/'))
-            + fileName.toString().mid(commonParent.size()).count(QLatin1Char('/'));
+    return m_titles.value(title, -1);
 }
+
+bool CMakeTargetDirectoryIndex::isBetter(int target, int other) const
+{
+    if (other == -1)
+        return true;
+    if (m_targetDepths.at(target) != m_targetDepths.at(other))
+        return m_targetDepths.at(target) < m_targetDepths.at(other);
+    if (m_targetIncludeCounts.at(target) != m_targetIncludeCounts.at(other))
+        return m_targetIncludeCounts.at(target) > m_targetIncludeCounts.at(other);
+    return target < other;
+}
+
+int CMakeTargetDirectoryIndex::subtreeBest(int node) const
+{
+    const Node &n = m_nodes.at(node);
+    if (n.ownBest != -1 && isBetter(n.ownBest, n.descendantBest))
+        return n.ownBest;
+    return n.descendantBest;
+}
+
+int CMakeTargetDirectoryIndex::computeBest(int node)
+{
+    int best = -1;
+    foreach (int child, m_nodes.at(node).children) {
+        const int childBest = computeBest(child);
+        if (childBest != -1 && isBetter(childBest, best))
+            best = childBest;
+    }
+    m_nodes[node].descendantBest = best;
+    return subtreeBest(node);
 }
 
 // called after everything is parsed
@@ -95,11 +275,12 @@ void CMakeCbpParser::sortFiles()
     qCDebug(log) << "# Sorting     #";
     qCDebug(log) << "###############";
 
+    const CMakeTargetDirectoryIndex targetIndex(m_buildTargets);
     foreach (const FileName &fileName, fileNames) {
         qCDebug(log) << fileName;
         const QString unitTarget = m_unitTargetMap[fileName];
         if (!unitTarget.isEmpty()) { // target was explicitly specified for that file
-            int index = Utils::indexOf(m_buildTargets, Utils::equal(&CMakeBuildTarget::title, unitTarget));
+            int index = targetIndex.targetForTitle(unitTarget);
             if (index != -1) {
                 m_buildTargets[index].files.append(fileName.toString());
                 qCDebug(log) << "  into" << m_buildTargets[index].title << "(target attribute)";
@@ -111,24 +292,7 @@ void CMakeCbpParser::sortFiles()
             last->files.append(fileName.toString());
             qCDebug(log) << "  into" << last->title << "(same parent)";
         } else {
-            int bestDistance = std::numeric_limits<int>::max();
-            int bestIndex = -1;
-            int bestIncludeCount = -1;
-
-            for (int i = 0; i < m_buildTargets.size(); ++i) {
-                const CMakeBuildTarget &target = m_buildTargets.at(i);
-                if (target.includeFiles.isEmpty())
-                    continue;
-                int dist = distance(target.sourceDirectory, fileName);
-                qCDebug(log) << "distance to target" << target.title << dist;
-                if (dist < bestDistance ||
-                     (dist == bestDistance &&
-                      target.includeFiles.count() > bestIncludeCount)) {
-                    bestDistance = dist;
-                    bestIncludeCount = target.includeFiles.count();
-                    bestIndex = i;
-                }
-            }
+            int bestIndex = targetIndex.bestTarget(fileName);
 
             if (bestIndex == -1 && !m_buildTargets.isEmpty()) {
                 bestIndex = fallbackIndex;
@@ -151,6 +315,11 @@ void CMakeCbpParser::sortFiles()
         qCDebug(log) << target.title << target.sourceDirectory << target.includeFiles << target.defines << target.files << "\n";
 }
 
+void CMakeCbpParser::setDirectoryInformationCache(CMakeDirectoryInformationCache *cache)
+{
+    m_directoryInformationCache = cache;
+}
+
 bool CMakeCbpParser::parseCbpFile(const Kit *const kit, const QString &fileName, const QString &sourceDirectory)
 {
     m_kit = kit;
@@ -159,16 +328,34 @@ bool CMakeCbpParser::parseCbpFile(const Kit *const kit, const QString &fileName,
 
     QFile fi(fileName);
     if (fi.exists() && fi.open(QFile::ReadOnly)) {
-        setDevice(&fi);
+        // Most of the time is spent in reading the file, so map it and only look at the
+        // parts that are needed.
+        QByteArray contents;
+        const char *data = nullptr;
+        qint64 size = fi.size();
+        if (size > 0) {
+            data = reinterpret_cast<const char *>(fi.map(0, size));
+            if (!data) {
+                contents = fi.readAll();
+                data = contents.constData();
+                size = contents.size();
+            }
+        }
+        CMakeCbpScanner scanner(data, size);
+        m_scanner = &scanner;
 
         while (!atEnd()) {
             readNext();
-            if (name() == QLatin1String("CodeBlocks_project_file"))
+            if (name() == "CodeBlocks_project_file")
                 parseCodeBlocks_project_file();
             else if (isStartElement())
                 parseUnknownElement();
         }
+        m_scanner = nullptr;
 
+        resolveSourceDirectories();
+        mapPaths();
+        createFileNodes();
         sortFiles();
 
         fi.close();
@@ -193,7 +380,7 @@ void CMakeCbpParser::parseCodeBlocks_project_file()
         readNext();
         if (isEndElement())
             return;
-        else if (name() == QLatin1String("Project"))
+        else if (name() == "Project")
             parseProject();
         else if (isStartElement())
             parseUnknownElement();
@@ -206,11 +393,11 @@ void CMakeCbpParser::parseProject()
         readNext();
         if (isEndElement())
             return;
-        else if (name() == QLatin1String("Option"))
+        else if (name() == "Option")
             parseOption();
-        else if (name() == QLatin1String("Unit"))
+        else if (name() == "Unit")
             parseUnit();
-        else if (name() == QLatin1String("Build"))
+        else if (name() == "Build")
             parseBuild();
         else if (isStartElement())
             parseUnknownElement();
@@ -223,7 +410,7 @@ void CMakeCbpParser::parseBuild()
         readNext();
         if (isEndElement())
             return;
-        else if (name() == QLatin1String("Target"))
+        else if (name() == "Target")
             parseBuildTarget();
         else if (isStartElement())
             parseUnknownElement();
@@ -234,8 +421,8 @@ void CMakeCbpParser::parseBuildTarget()
 {
     m_buildTarget.clear();
 
-    if (attributes().hasAttribute(QLatin1String("title")))
-        m_buildTarget.title = attributes().value(QLatin1String("title")).toString();
+    if (hasAttribute("title"))
+        m_buildTarget.title = attribute("title").toString();
     while (!atEnd()) {
         readNext();
         if (isEndElement()) {
@@ -243,11 +430,11 @@ void CMakeCbpParser::parseBuildTarget()
                     && !m_buildTarget.title.endsWith(QLatin1String("_automoc")))
                 m_buildTargets.append(m_buildTarget);
             return;
-        } else if (name() == QLatin1String("Compiler")) {
+        } else if (name() == "Compiler") {
             parseCompiler();
-        } else if (name() == QLatin1String("Option")) {
+        } else if (name() == "Option") {
             parseBuildTargetOption();
-        } else if (name() == QLatin1String("MakeCommands")) {
+        } else if (name() == "MakeCommands") {
             parseMakeCommands();
         } else if (isStartElement()) {
             parseUnknownElement();
@@ -257,39 +444,17 @@ void CMakeCbpParser::parseBuildTarget()
 
 void CMakeCbpParser::parseBuildTargetOption()
 {
-    if (attributes().hasAttribute(QLatin1String("output"))) {
-        m_buildTarget.executable = attributes().value(QLatin1String("output")).toString();
-        CMakeTool *tool = CMakeKitInformation::cmakeTool(m_kit);
-        if (tool)
-            m_buildTarget.executable = tool->mapAllPaths(m_kit, m_buildTarget.executable);
-    } else if (attributes().hasAttribute(QLatin1String("type"))) {
-        const QStringRef value = attributes().value(QLatin1String("type"));
-        if (value == QLatin1String("2") || value == QLatin1String("3"))
-            m_buildTarget.targetType = TargetType(value.toInt());
-    } else if (attributes().hasAttribute(QLatin1String("working_dir"))) {
-        m_buildTarget.workingDirectory = attributes().value(QLatin1String("working_dir")).toString();
-
-        QFile cmakeSourceInfoFile(m_buildTarget.workingDirectory
-                                  + QStringLiteral("/CMakeFiles/CMakeDirectoryInformation.cmake"));
-        if (cmakeSourceInfoFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream stream(&cmakeSourceInfoFile);
-            const QLatin1String searchSource("SET(CMAKE_RELATIVE_PATH_TOP_SOURCE \"");
-            while (!stream.atEnd()) {
-                const QString lineTopSource = stream.readLine().trimmed();
-                if (lineTopSource.startsWith(searchSource, Qt::CaseInsensitive)) {
-                    m_buildTarget.sourceDirectory = lineTopSource.mid(searchSource.size());
-                    m_buildTarget.sourceDirectory.chop(2); // cut off ")
-                    break;
-                }
-            }
-        }
-
-        if (m_buildTarget.sourceDirectory.isEmpty()) {
-            QDir dir(m_buildDirectory);
-            const QString relative = dir.relativeFilePath(m_buildTarget.workingDirectory);
-            m_buildTarget.sourceDirectory
-                    = FileName::fromString(m_sourceDirectory).appendPath(relative).toString();
-        }
+    if (hasAttribute("output")) {
+        m_buildTarget.executable = attribute("output").toString();
+    } else if (hasAttribute("type")) {
+        const CbpStringRef value = attribute("type");
+        if (value == "2")
+            m_buildTarget.targetType = StaticLibraryType;
+        else if (value == "3")
+            m_buildTarget.targetType = DynamicLibraryType;
+    } else if (hasAttribute("working_dir")) {
+        // The source directory is resolved after parsing, see resolveSourceDirectories()
+        m_buildTarget.workingDirectory = attribute("working_dir").toString();
     }
     while (!atEnd()) {
         readNext();
@@ -307,11 +472,11 @@ QString CMakeCbpParser::projectName() const
 
 void CMakeCbpParser::parseOption()
 {
-    if (attributes().hasAttribute(QLatin1String("title")))
-        m_projectName = attributes().value(QLatin1String("title")).toString();
+    if (hasAttribute("title"))
+        m_projectName = attribute("title").toString();
 
-    if (attributes().hasAttribute(QLatin1String("compiler")))
-        m_compiler = attributes().value(QLatin1String("compiler")).toString();
+    if (hasAttribute("compiler"))
+        m_compiler = attribute("compiler").toString();
 
     while (!atEnd()) {
         readNext();
@@ -328,9 +493,9 @@ void CMakeCbpParser::parseMakeCommands()
         readNext();
         if (isEndElement())
             return;
-        else if (name() == QLatin1String("Build"))
+        else if (name() == "Build")
             parseBuildTargetBuild();
-        else if (name() == QLatin1String("Clean"))
+        else if (name() == "Clean")
             parseBuildTargetClean();
         else if (isStartElement())
             parseUnknownElement();
@@ -339,12 +504,8 @@ void CMakeCbpParser::parseMakeCommands()
 
 void CMakeCbpParser::parseBuildTargetBuild()
 {
-    if (attributes().hasAttribute(QLatin1String("command"))) {
-        m_buildTarget.makeCommand = attributes().value(QLatin1String("command")).toString();
-
-        CMakeTool *tool = CMakeKitInformation::cmakeTool(m_kit);
-        if (tool)
-            m_buildTarget.makeCommand = tool->mapAllPaths(m_kit, m_buildTarget.makeCommand);
+    if (hasAttribute("command")) {
+        m_buildTarget.makeCommand = attribute("command").toString();
     }
     while (!atEnd()) {
         readNext();
@@ -357,12 +518,8 @@ void CMakeCbpParser::parseBuildTargetBuild()
 
 void CMakeCbpParser::parseBuildTargetClean()
 {
-    if (attributes().hasAttribute(QLatin1String("command"))) {
-        m_buildTarget.makeCleanCommand = attributes().value(QLatin1String("command")).toString();
-
-        CMakeTool *tool = CMakeKitInformation::cmakeTool(m_kit);
-        if (tool)
-            m_buildTarget.makeCleanCommand = tool->mapAllPaths(m_kit, m_buildTarget.makeCleanCommand);
+    if (hasAttribute("command")) {
+        m_buildTarget.makeCleanCommand = attribute("command").toString();
     }
     while (!atEnd()) {
         readNext();
@@ -379,7 +536,7 @@ void CMakeCbpParser::parseCompiler()
         readNext();
         if (isEndElement())
             return;
-        else if (name() == QLatin1String("Add"))
+        else if (name() == "Add")
             parseAdd();
         else if (isStartElement())
             parseUnknownElement();
@@ -389,19 +546,13 @@ void CMakeCbpParser::parseCompiler()
 void CMakeCbpParser::parseAdd()
 {
     // CMake only supports <Add option=\> and <Add directory=\>
-    const QXmlStreamAttributes addAttributes = attributes();
-
-    QString includeDirectory = addAttributes.value(QLatin1String("directory")).toString();
-
-    CMakeTool *tool = CMakeKitInformation::cmakeTool(m_kit);
-    if (tool)
-        includeDirectory = tool->mapAllPaths(m_kit, includeDirectory);
+    const QString includeDirectory = attribute("directory").toString();
 
     // allow adding multiple times because order happens
     if (!includeDirectory.isEmpty())
         m_buildTarget.includeFiles.append(includeDirectory);
 
-    QString compilerOption = addAttributes.value(QLatin1String("option")).toString();
+    QString compilerOption = attribute("option").toString();
     // defining multiple times a macro to the same value makes no sense
     if (!compilerOption.isEmpty() && !m_buildTarget.compilerOptions.contains(compilerOption)) {
         m_buildTarget.compilerOptions.append(compilerOption);
@@ -427,44 +578,20 @@ void CMakeCbpParser::parseAdd()
 
 void CMakeCbpParser::parseUnit()
 {
-    //qDebug()<<stream.attributes().value("filename");
-    FileName fileName =
-            FileName::fromUserInput(attributes().value(QLatin1String("filename")).toString());
-
-    CMakeTool *tool = CMakeKitInformation::cmakeTool(m_kit);
-    if (tool) {
-        QString mappedFile = tool->mapAllPaths(m_kit, fileName.toString());
-        fileName = FileName::fromUserInput(mappedFile);
-    }
+    Unit unit;
+    unit.fileName = FileName::fromUserInput(attribute("filename").toString()).toString();
 
     m_parsingCMakeUnit = false;
     m_unitTarget.clear();
     while (!atEnd()) {
         readNext();
         if (isEndElement()) {
-            if (!fileName.endsWith(QLatin1String(".rule")) && !m_processedUnits.contains(fileName)) {
-                // Now check whether we found a virtual element beneath
-                if (m_parsingCMakeUnit) {
-                    m_cmakeFileList.append( new ProjectExplorer::FileNode(fileName, ProjectExplorer::ProjectFileType, false));
-                } else {
-                    bool generated = false;
-                    QString onlyFileName = fileName.fileName();
-                    if (   (onlyFileName.startsWith(QLatin1String("moc_")) && onlyFileName.endsWith(QLatin1String(".cxx")))
-                        || (onlyFileName.startsWith(QLatin1String("ui_")) && onlyFileName.endsWith(QLatin1String(".h")))
-                        || (onlyFileName.startsWith(QLatin1String("qrc_")) && onlyFileName.endsWith(QLatin1String(".cxx"))))
-                        generated = true;
-
-                    if (fileName.endsWith(QLatin1String(".qrc")))
-                        m_fileList.append( new ProjectExplorer::FileNode(fileName, ProjectExplorer::ResourceType, generated));
-                    else
-                        m_fileList.append( new ProjectExplorer::FileNode(fileName, ProjectExplorer::SourceType, generated));
-                }
-                if (!m_unitTarget.isEmpty())
-                    m_unitTargetMap.insert(fileName, m_unitTarget);
-                m_processedUnits.insert(fileName);
-            }
+            // File nodes are created once all paths are mapped
+            unit.isCMakeFile = m_parsingCMakeUnit;
+            unit.target = m_unitTarget;
+            m_units.append(unit);
             return;
-        } else if (name() == QLatin1String("Option")) {
+        } else if (name() == "Option") {
             parseUnitOption();
         } else if (isStartElement()) {
             parseUnknownElement();
@@ -472,11 +599,99 @@ void CMakeCbpParser::parseUnit()
     }
 }
 
+void CMakeCbpParser::resolveSourceDirectories()
+{
+    CMakeDirectoryInformationCache localCache;
+    CMakeDirectoryInformationCache *cache
+            = m_directoryInformationCache ? m_directoryInformationCache : &localCache;
+
+    // Many targets share their working directory
+    QStringList workingDirectories;
+    QSet<QString> seen;
+    foreach (const CMakeBuildTarget &target, m_buildTargets) {
+        if (!target.workingDirectory.isEmpty() && !seen.contains(target.workingDirectory)) {
+            seen.insert(target.workingDirectory);
+            workingDirectories.append(target.workingDirectory);
+        }
+    }
+
+    const QHash<QString, QString> sourceDirectories = cache->sourceDirectories(workingDirectories);
+    for (CMakeBuildTarget &target : m_buildTargets) {
+        if (target.workingDirectory.isEmpty())
+            continue;
+        target.sourceDirectory = sourceDirectories.value(target.workingDirectory);
+        if (target.sourceDirectory.isEmpty()) {
+            QDir dir(m_buildDirectory);
+            const QString relative = dir.relativeFilePath(target.workingDirectory);
+            target.sourceDirectory
+                    = FileName::fromString(m_sourceDirectory).appendPath(relative).toString();
+        }
+    }
+}
+
+// Maps all paths of units and targets in one go, instead of once per attribute
+void CMakeCbpParser::mapPaths()
+{
+    CMakeTool *tool = CMakeKitInformation::cmakeTool(m_kit);
+    if (!tool)
+        return;
+
+    QStringList paths;
+    foreach (const Unit &unit, m_units)
+        paths.append(unit.fileName);
+    foreach (const CMakeBuildTarget &target, m_buildTargets) {
+        paths << target.executable << target.makeCommand << target.makeCleanCommand;
+        paths += target.includeFiles;
+    }
+
+    tool->mapAllPaths(m_kit, paths);
+
+    auto path = paths.constBegin();
+    for (Unit &unit : m_units)
+        unit.fileName = *path++;
+    for (CMakeBuildTarget &target : m_buildTargets) {
+        target.executable = *path++;
+        target.makeCommand = *path++;
+        target.makeCleanCommand = *path++;
+        for (QString &includeFile : target.includeFiles)
+            includeFile = *path++;
+    }
+}
+
+void CMakeCbpParser::createFileNodes()
+{
+    foreach (const Unit &unit, m_units) {
+        const FileName fileName = FileName::fromUserInput(unit.fileName);
+        if (fileName.endsWith(QLatin1String(".rule")) || m_processedUnits.contains(fileName))
+            continue;
+
+        // Now check whether we found a virtual element beneath
+        if (unit.isCMakeFile) {
+            m_cmakeFileList.append( new ProjectExplorer::FileNode(fileName, ProjectExplorer::ProjectFileType, false));
+        } else {
+            bool generated = false;
+            QString onlyFileName = fileName.fileName();
+            if (   (onlyFileName.startsWith(QLatin1String("moc_")) && onlyFileName.endsWith(QLatin1String(".cxx")))
+                || (onlyFileName.startsWith(QLatin1String("ui_")) && onlyFileName.endsWith(QLatin1String(".h")))
+                || (onlyFileName.startsWith(QLatin1String("qrc_")) && onlyFileName.endsWith(QLatin1String(".cxx"))))
+                generated = true;
+
+            if (fileName.endsWith(QLatin1String(".qrc")))
+                m_fileList.append( new ProjectExplorer::FileNode(fileName, ProjectExplorer::ResourceType, generated));
+            else
+                m_fileList.append( new ProjectExplorer::FileNode(fileName, ProjectExplorer::SourceType, generated));
+        }
+        if (!unit.target.isEmpty())
+            m_unitTargetMap.insert(fileName, unit.target);
+        m_processedUnits.insert(fileName);
+    }
+    m_units.clear();
+}
+
 void CMakeCbpParser::parseUnitOption()
 {
-    const QXmlStreamAttributes optionAttributes = attributes();
-    m_parsingCMakeUnit = optionAttributes.hasAttribute(QLatin1String("virtualFolder"));
-    m_unitTarget = optionAttributes.value(QLatin1String("target")).toString();
+    m_parsingCMakeUnit = hasAttribute("virtualFolder");
+    m_unitTarget = attribute("target").toString();
 
     while (!atEnd()) {
         readNext();
@@ -529,6 +744,136 @@ QString CMakeCbpParser::compilerName() const
     return m_compiler;
 }
 
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+
+namespace {
+
+QList<CMakeBuildTarget> testTargets(const QStringList &directories, const QList<int> &includeCounts)
+{
+    QList<CMakeBuildTarget> targets;
+    for (int i = 0; i < directories.size(); ++i) {
+        CMakeBuildTarget target;
+        target.title = QString::fromLatin1("target%1").arg(i);
+        target.sourceDirectory = directories.at(i);
+        for (int j = 0; j < includeCounts.at(i); ++j)
+            target.includeFiles.append(QString::fromLatin1("/include%1").arg(j));
+        targets.append(target);
+    }
+    return targets;
+}
+
+// How sortFiles() used to pick targets, by comparing each file with each target.
+int bestTargetByDistance(const QList<CMakeBuildTarget> &targets, const FileName &fileName)
+{
+    int bestDistance = std::numeric_limits<int>::max();
+    int bestIndex = -1;
+    int bestIncludeCount = -1;
+    for (int i = 0; i < targets.size(); ++i) {
+        const CMakeBuildTarget &target = targets.at(i);
+        if (target.includeFiles.isEmpty())
+            continue;
+        const QString commonParent
+                = Utils::commonPath(QStringList() << target.sourceDirectory << fileName.toString());
+        const int dist = target.sourceDirectory.mid(commonParent.size()).count(QLatin1Char('/'))
+                + fileName.toString().mid(commonParent.size()).count(QLatin1Char('/'));
+        if (dist < bestDistance
+                || (dist == bestDistance && target.includeFiles.count() > bestIncludeCount)) {
+            bestDistance = dist;
+            bestIncludeCount = target.includeFiles.count();
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+} // namespace
+
+void CMakeProjectPlugin::testCMakeTargetDirectoryIndex_data()
+{
+    QTest::addColumn<QStringList>("directories");
+    QTest::addColumn<QList<int> >("includeCounts");
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("expectedTarget");
+
+    const QStringList directories = QStringList()
+            << QLatin1String("/src/app") << QLatin1String("/src/lib")
+            << QLatin1String("/src/lib/sub") << QLatin1String("/src/libfoo")
+            << QLatin1String("/src/lib/core") << QLatin1String("/src/lib")
+            << QLatin1String("/src/tools/gen");
+    const QList<int> includeCounts = QList<int>() << 2 << 3 << 0 << 1 << 1 << 4 << 5;
+
+    QTest::newRow("target directory")
+            << directories << includeCounts << QString::fromLatin1("/src/app/main.cpp") << 5;
+    QTest::newRow("below target directory")
+            << directories << includeCounts << QString::fromLatin1("/src/app/ui/form.cpp") << 5;
+    QTest::newRow("target without includes")
+            << directories << includeCounts << QString::fromLatin1("/src/lib/sub/x.cpp") << 4;
+    QTest::newRow("directory name prefix")
+            << directories << includeCounts << QString::fromLatin1("/src/libfoo/a.cpp") << 5;
+    QTest::newRow("sibling target is closer")
+            << directories << includeCounts << QString::fromLatin1("/src/lib/a.cpp") << 4;
+    QTest::newRow("outside of the project")
+            << directories << includeCounts << QString::fromLatin1("/other/x.cpp") << 5;
+    QTest::newRow("only one deep target")
+            << directories << includeCounts << QString::fromLatin1("/src/tools/t.cpp") << 6;
+    QTest::newRow("no target with includes")
+            << (QStringList() << QLatin1String("/src/lib/sub")) << (QList<int>() << 0)
+            << QString::fromLatin1("/src/lib/sub/x.cpp") << -1;
+}
+
+void CMakeProjectPlugin::testCMakeTargetDirectoryIndex()
+{
+    QFETCH(QStringList, directories);
+    QFETCH(QList<int>, includeCounts);
+    QFETCH(QString, fileName);
+    QFETCH(int, expectedTarget);
+
+    const QList<CMakeBuildTarget> targets = testTargets(directories, includeCounts);
+    const CMakeTargetDirectoryIndex index(targets);
+    const FileName file = FileName::fromString(fileName);
+
+    QCOMPARE(index.bestTarget(file), expectedTarget);
+    QCOMPARE(index.bestTarget(file), bestTargetByDistance(targets, file));
+    if (expectedTarget != -1)
+        QCOMPARE(index.targetForTitle(targets.at(expectedTarget).title), expectedTarget);
+}
+
+void CMakeProjectPlugin::testCMakeTargetDirectoryIndexBenchmark()
+{
+    // 1000 targets in a tree of 50 modules with 20 components each, 100000 units
+    QStringList directories;
+    QList<int> includeCounts;
+    for (int module = 0; module < 50; ++module) {
+        for (int component = 0; component < 20; ++component) {
+            directories << QString::fromLatin1("/home/user/project/src/module%1/component%2")
+                           .arg(module).arg(component);
+            includeCounts << 1 + (module + component) % 5;
+        }
+    }
+    const QList<CMakeBuildTarget> targets = testTargets(directories, includeCounts);
+
+    FileNameList fileNames;
+    for (int i = 0; i < 100000; ++i) {
+        fileNames << FileName::fromString(QString::fromLatin1("%1/sub%2/file%3.cpp")
+                                          .arg(directories.at(i % directories.size()))
+                                          .arg(i % 3).arg(i));
+    }
+
+    const CMakeTargetDirectoryIndex index(targets);
+    for (int i = 0; i < fileNames.size(); i += 997)
+        QCOMPARE(index.bestTarget(fileNames.at(i)), bestTargetByDistance(targets, fileNames.at(i)));
+
+    QBENCHMARK {
+        const CMakeTargetDirectoryIndex index(targets);
+        foreach (const FileName &fileName, fileNames)
+            index.bestTarget(fileName);
+    }
+}
+
+#endif
 
 } // namespace Internal
 } // namespace CMakeProjectManager
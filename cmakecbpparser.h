@@ -25,15 +25,18 @@
 
 #pragma once
 
+#include "cmakecbpscanner.h"
 #include "cmakeproject.h"
 
 #include <utils/fileutils.h>
 
+#include <QDateTime>
+#include <QHash>
 #include <QList>
+#include <QVector>
 #include <QMap>
 #include <QSet>
 #include <QString>
-#include <QXmlStreamReader>
 
 namespace ProjectExplorer {
 class FileNode;
@@ -43,9 +46,61 @@ class Kit;
 namespace CMakeProjectManager {
 namespace Internal {
 
-class CMakeCbpParser : public QXmlStreamReader
+// Finds the build target a file most likely belongs to, in O(path depth) per file.
+// Targets without include paths are never picked, as they carry no code model information.
+class CMakeTargetDirectoryIndex
 {
 public:
+    explicit CMakeTargetDirectoryIndex(const QList<CMakeBuildTarget> &targets);
+
+    // Index of the target whose source directory is closest to fileName, -1 if there is none.
+    // Ties are resolved in favor of the target with more include paths, then the earlier one.
+    int bestTarget(const Utils::FileName &fileName) const;
+    // Index of the first target with that title, -1 if there is none.
+    int targetForTitle(const QString &title) const;
+
+private:
+    struct Node {
+        QHash<QString, int> children;
+        int depth = 0;          // number of '/' in the directory path
+        int ownBest = -1;       // best target with this source directory
+        int descendantBest = -1; // best target in a subdirectory
+    };
+
+    bool isBetter(int target, int other) const; // Ranks targets below the same directory
+    int subtreeBest(int node) const;
+    int computeBest(int node);
+
+    QVector<Node> m_nodes;
+    QVector<int> m_targetDepths;
+    QVector<int> m_targetIncludeCounts;
+    QHash<QString, int> m_titles;
+};
+
+// Reads the source directories of build directories from the
+// CMakeFiles/CMakeDirectoryInformation.cmake files CMake generates. The files are read
+// concurrently, and only again when they changed.
+class CMakeDirectoryInformationCache
+{
+public:
+    // working directory -> source directory, empty if the file does not tell
+    QHash<QString, QString> sourceDirectories(const QStringList &workingDirectories);
+
+private:
+    struct Entry {
+        QDateTime lastModified;
+        QString sourceDirectory;
+    };
+
+    QHash<QString, Entry> m_entries;
+};
+
+class CMakeCbpParser
+{
+public:
+    // The cache is used for the next parseCbpFile() calls, if there is none, one is created for
+    // each call.
+    void setDirectoryInformationCache(CMakeDirectoryInformationCache *cache);
     bool parseCbpFile(const ProjectExplorer::Kit *const kit, const QString &fileName,
                       const QString &sourceDirectory);
     QList<ProjectExplorer::FileNode *> fileList();
@@ -56,6 +111,15 @@ public:
     bool hasCMakeFiles();
 
 private:
+    // The scanner of the file being parsed
+    void readNext() { m_scanner->readNext(); }
+    bool atEnd() const { return m_scanner->atEnd(); }
+    bool isStartElement() const { return m_scanner->isStartElement(); }
+    bool isEndElement() const { return m_scanner->isEndElement(); }
+    CbpStringRef name() const { return m_scanner->name(); }
+    CbpStringRef attribute(const char *name) const { return m_scanner->attribute(name); }
+    bool hasAttribute(const char *name) const { return m_scanner->hasAttribute(name); }
+
     void parseCodeBlocks_project_file();
     void parseProject();
     void parseBuild();
@@ -70,8 +134,20 @@ private:
     void parseUnit();
     void parseUnitOption();
     void parseUnknownElement();
+    void resolveSourceDirectories();
+    void mapPaths();
+    void createFileNodes();
     void sortFiles();
 
+    struct Unit {
+        QString fileName;
+        bool isCMakeFile = false;
+        QString target;
+    };
+
+    CMakeCbpScanner *m_scanner = nullptr;
+    CMakeDirectoryInformationCache *m_directoryInformationCache = nullptr;
+    QList<Unit> m_units;
     QMap<Utils::FileName, QString> m_unitTargetMap;
     const ProjectExplorer::Kit *m_kit = 0;
     QList<ProjectExplorer::FileNode *> m_fileList;
@@ -0,0 +1,412 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakecbpscanner.h"
+
+#include <cstring>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+const char *skipSpaces(const char *pos, const char *end)
+{
+    while (pos < end && isSpace(*pos))
+        ++pos;
+    return pos;
+}
+
+const char *find(const char *pos, const char *end, char c)
+{
+    if (pos >= end)
+        return nullptr;
+    return static_cast<const char *>(memchr(pos, c, size_t(end - pos)));
+}
+
+// Returns the position right after the next occurrence of sequence, or nullptr.
+const char *findEndOf(const char *pos, const char *end, const char *sequence)
+{
+    const size_t length = strlen(sequence);
+    while ((pos = find(pos, end, sequence[0]))) {
+        if (size_t(end - pos) < length)
+            return nullptr;
+        if (memcmp(pos, sequence, length) == 0)
+            return pos + length;
+        ++pos;
+    }
+    return nullptr;
+}
+
+bool startsWith(const char *pos, const char *end, const char *prefix)
+{
+    const size_t length = strlen(prefix);
+    return size_t(end - pos) >= length && memcmp(pos, prefix, length) == 0;
+}
+
+void appendEntity(QString &result, const char *begin, const char *end)
+{
+    const QByteArray entity = QByteArray::fromRawData(begin, int(end - begin));
+    if (entity == "lt") {
+        result += QLatin1Char('<');
+    } else if (entity == "gt") {
+        result += QLatin1Char('>');
+    } else if (entity == "amp") {
+        result += QLatin1Char('&');
+    } else if (entity == "quot") {
+        result += QLatin1Char('"');
+    } else if (entity == "apos") {
+        result += QLatin1Char('\'');
+    } else if (entity.startsWith('#')) {
+        bool ok;
+        const uint code = entity.startsWith("#x") ? entity.mid(2).toUInt(&ok, 16)
+                                                  : entity.mid(1).toUInt(&ok, 10);
+        if (ok)
+            result += QString::fromUcs4(&code, 1);
+    }
+}
+
+} // namespace
+
+bool CbpStringRef::operator==(const char *latin1) const
+{
+    const size_t length = strlen(latin1);
+    return m_data && size_t(m_size) == length && memcmp(m_data, latin1, length) == 0;
+}
+
+QString CbpStringRef::toString() const
+{
+    const char *pos = m_data;
+    const char *end = m_data + m_size;
+    const char *special = pos;
+    while (special < end && *special != '&' && *special != '\t'
+           && *special != '\n' && *special != '\r') {
+        ++special;
+    }
+    if (special == end)
+        return QString::fromUtf8(m_data, m_size);
+
+    // Decode entities and normalize white space like any XML parser does for attribute values
+    QString result;
+    result.reserve(m_size);
+    while (pos < end) {
+        const char *run = pos;
+        while (pos < end && *pos != '&' && *pos != '\t' && *pos != '\n' && *pos != '\r')
+            ++pos;
+        result += QString::fromUtf8(run, int(pos - run));
+        if (pos == end)
+            break;
+        if (*pos == '&') {
+            const char *semicolon = find(pos, end, ';');
+            if (!semicolon) {
+                result += QString::fromUtf8(pos, int(end - pos));
+                break;
+            }
+            appendEntity(result, pos + 1, semicolon);
+            pos = semicolon + 1;
+        } else {
+            result += QLatin1Char(' ');
+            ++pos;
+        }
+    }
+    return result;
+}
+
+CMakeCbpScanner::CMakeCbpScanner(const char *data, qint64 size) :
+    m_pos(data),
+    m_end(data + size)
+{ }
+
+CMakeCbpScanner::TokenType CMakeCbpScanner::readNext()
+{
+    if (atEnd())
+        return m_tokenType;
+
+    m_attributesBegin = m_attributesEnd = nullptr;
+
+    if (m_pendingEndElement) {
+        // The name of the self-closing element is still valid
+        m_pendingEndElement = false;
+        return m_tokenType = EndElement;
+    }
+
+    forever {
+        const char *lt = find(m_pos, m_end, '<');
+        if (!lt) {
+            m_name = CbpStringRef();
+            return m_tokenType = EndDocument;
+        }
+        const char *pos = lt + 1;
+        if (pos == m_end)
+            return setInvalid();
+
+        if (*pos == '?') {
+            m_pos = findEndOf(pos, m_end, "?>");
+        } else if (*pos == '!') {
+            if (startsWith(pos, m_end, "!--"))
+                m_pos = findEndOf(pos + 3, m_end, "-->");
+            else if (startsWith(pos, m_end, "![CDATA["))
+                m_pos = findEndOf(pos, m_end, "]]>");
+            else
+                m_pos = findEndOf(pos, m_end, ">");
+        } else if (*pos == '/') {
+            const char *nameBegin = ++pos;
+            while (pos < m_end && *pos != '>' && !isSpace(*pos))
+                ++pos;
+            m_name = CbpStringRef(nameBegin, int(pos - nameBegin));
+            m_pos = findEndOf(pos, m_end, ">");
+            if (!m_pos)
+                return setInvalid();
+            return m_tokenType = EndElement;
+        } else {
+            const char *nameBegin = pos;
+            while (pos < m_end && *pos != '>' && *pos != '/' && !isSpace(*pos))
+                ++pos;
+            m_name = CbpStringRef(nameBegin, int(pos - nameBegin));
+
+            // Find the end of the tag, '>' may appear in quoted attribute values
+            m_attributesBegin = pos;
+            while (pos < m_end && *pos != '>') {
+                if (*pos == '"' || *pos == '\'') {
+                    pos = find(pos + 1, m_end, *pos);
+                    if (!pos)
+                        return setInvalid();
+                }
+                ++pos;
+            }
+            if (pos == m_end || m_name.isEmpty())
+                return setInvalid();
+            m_attributesEnd = pos;
+            if (pos[-1] == '/' && pos - 1 >= m_attributesBegin) {
+                --m_attributesEnd;
+                m_pendingEndElement = true;
+            }
+            m_pos = pos + 1;
+            return m_tokenType = StartElement;
+        }
+
+        if (!m_pos)
+            return setInvalid();
+    }
+}
+
+CbpStringRef CMakeCbpScanner::attribute(const char *name) const
+{
+    const size_t nameLength = strlen(name);
+    const char *pos = m_attributesBegin;
+    const char *end = m_attributesEnd;
+    if (!pos)
+        return CbpStringRef();
+
+    forever {
+        pos = skipSpaces(pos, end);
+        const char *attributeName = pos;
+        while (pos < end && *pos != '=' && !isSpace(*pos))
+            ++pos;
+        const size_t attributeNameLength = size_t(pos - attributeName);
+        pos = skipSpaces(pos, end);
+        if (pos == end || *pos != '=')
+            return CbpStringRef();
+        pos = skipSpaces(pos + 1, end);
+        if (pos == end || (*pos != '"' && *pos != '\''))
+            return CbpStringRef();
+        const char *valueEnd = find(pos + 1, end, *pos);
+        if (!valueEnd)
+            return CbpStringRef();
+        if (attributeNameLength == nameLength && memcmp(attributeName, name, nameLength) == 0)
+            return CbpStringRef(pos + 1, int(valueEnd - pos - 1));
+        pos = valueEnd + 1;
+    }
+}
+
+CMakeCbpScanner::TokenType CMakeCbpScanner::setInvalid()
+{
+    m_pos = m_end;
+    m_name = CbpStringRef();
+    m_pendingEndElement = false;
+    return m_tokenType = Invalid;
+}
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+#include <QXmlStreamReader>
+
+namespace {
+
+// Something that looks like what CMake writes, with as many targets as needed for the size,
+// but at least one
+QByteArray generateCbpFile(int megabytes)
+{
+    QByteArray cbp = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                     "<CodeBlocks_project_file>\n"
+                     "\t<FileVersion major=\"1\" minor=\"6\"/>\n"
+                     "\t<Project>\n"
+                     "\t\t<Option title=\"Generated\"/>\n"
+                     "\t\t<Option makefile_is_custom=\"1\"/>\n"
+                     "\t\t<Option compiler=\"gcc\"/>\n"
+                     "\t\t<Build>\n";
+    QByteArray units;
+    const int size = megabytes * 1024 * 1024;
+    for (int target = 0; target == 0 || cbp.size() + units.size() < size; ++target) {
+        const QByteArray name = "target" + QByteArray::number(target);
+        const QByteArray dir = "/home/user/project/build/src/module" + QByteArray::number(target);
+        cbp += "\t\t\t<Target title=\"" + name + "\">\n"
+               "\t\t\t\t<Option output=\"" + dir + "/lib" + name + ".so\" prefix_auto=\"0\" extension_auto=\"0\"/>\n"
+               "\t\t\t\t<Option working_dir=\"" + dir + "\"/>\n"
+               "\t\t\t\t<Option object_output=\"./\"/>\n"
+               "\t\t\t\t<Option type=\"3\"/>\n"
+               "\t\t\t\t<Option compiler=\"gcc\"/>\n"
+               "\t\t\t\t<Compiler>\n";
+        for (int i = 0; i < 10; ++i) {
+            cbp += "\t\t\t\t\t<Add option=\"-DDEFINE" + QByteArray::number(i) + "=&quot;value&quot;\"/>\n"
+                   "\t\t\t\t\t<Add directory=\"/home/user/project/include" + QByteArray::number(i) + "\"/>\n";
+        }
+        cbp += "\t\t\t\t</Compiler>\n"
+               "\t\t\t\t<MakeCommands>\n"
+               "\t\t\t\t\t<Build command=\"/usr/bin/make -f &quot;" + dir + "/Makefile&quot; " + name + "\"/>\n"
+               "\t\t\t\t\t<CompileFile command=\"/usr/bin/make -f &quot;" + dir + "/Makefile&quot; &quot;$file&quot;\"/>\n"
+               "\t\t\t\t\t<Clean command=\"/usr/bin/make -f &quot;" + dir + "/Makefile&quot; clean\"/>\n"
+               "\t\t\t\t\t<DistClean command=\"/usr/bin/make -f &quot;" + dir + "/Makefile&quot; clean\"/>\n"
+               "\t\t\t\t</MakeCommands>\n"
+               "\t\t\t</Target>\n";
+        for (int i = 0; i < 20; ++i) {
+            units += "\t\t<Unit filename=\"/home/user/project/src/module" + QByteArray::number(target)
+                    + "/file" + QByteArray::number(i) + ".cpp\">\n"
+                    "\t\t\t<Option target=\"" + name + "\"/>\n"
+                    "\t\t</Unit>\n";
+        }
+    }
+    cbp += "\t\t</Build>\n" + units + "\t</Project>\n</CodeBlocks_project_file>\n";
+    return cbp;
+}
+
+const char *const attributeNames[] = {
+    "title", "compiler", "output", "type", "working_dir", "command", "directory", "option",
+    "filename", "virtualFolder", "target"
+};
+
+} // namespace
+
+void CMakeProjectPlugin::testCMakeCbpScanner()
+{
+    const QByteArray cbp = generateCbpFile(0)
+            + "<!-- <Unit filename=\"comment\"/> -->\n"
+              "<Unit filename='a&lt;b&gt;&amp;&#65;&#x42;.cpp' other=\"x > y\">\n"
+              "<Option\n\tvirtualFolder=\"CMake Files\\\"/></Unit>\n";
+
+    // Report the same elements and attribute values as QXmlStreamReader
+    QXmlStreamReader reader(cbp);
+    CMakeCbpScanner scanner(cbp.constData(), cbp.size());
+    int elements = 0;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            QCOMPARE(scanner.readNext(), CMakeCbpScanner::StartElement);
+            QCOMPARE(scanner.name().toString(), reader.name().toString());
+            foreach (const char *name, attributeNames) {
+                const QLatin1String attributeName(name);
+                QCOMPARE(scanner.hasAttribute(name), reader.attributes().hasAttribute(attributeName));
+                QCOMPARE(scanner.attribute(name).toString(),
+                         reader.attributes().value(attributeName).toString());
+            }
+            ++elements;
+        } else if (reader.isEndElement()) {
+            QCOMPARE(scanner.readNext(), CMakeCbpScanner::EndElement);
+            QCOMPARE(scanner.name().toString(), reader.name().toString());
+        }
+    }
+    QVERIFY(elements > 0);
+    QCOMPARE(scanner.readNext(), CMakeCbpScanner::EndDocument);
+    QVERIFY(!scanner.hasError());
+
+    CMakeCbpScanner truncated(cbp.constData(), cbp.indexOf("<Add") + 10);
+    while (!truncated.atEnd())
+        truncated.readNext();
+    QVERIFY(truncated.hasError());
+}
+
+void CMakeProjectPlugin::testCMakeCbpScannerBenchmark_data()
+{
+    QTest::addColumn<int>("megabytes");
+    QTest::addColumn<bool>("useScanner");
+
+    foreach (int megabytes, QList<int>() << 10 << 50 << 100) {
+        QTest::newRow(qPrintable(QString::fromLatin1("QXmlStreamReader %1 MB").arg(megabytes)))
+                << megabytes << false;
+        QTest::newRow(qPrintable(QString::fromLatin1("CMakeCbpScanner %1 MB").arg(megabytes)))
+                << megabytes << true;
+    }
+}
+
+void CMakeProjectPlugin::testCMakeCbpScannerBenchmark()
+{
+    QFETCH(int, megabytes);
+    QFETCH(bool, useScanner);
+
+    const QByteArray cbp = generateCbpFile(megabytes);
+
+    // Look at the attributes of all elements like the cbp parser does (and did)
+    int strings = 0;
+    if (useScanner) {
+        QBENCHMARK {
+            CMakeCbpScanner scanner(cbp.constData(), cbp.size());
+            while (!scanner.atEnd()) {
+                if (scanner.readNext() != CMakeCbpScanner::StartElement)
+                    continue;
+                foreach (const char *name, attributeNames) {
+                    if (scanner.hasAttribute(name))
+                        strings += scanner.attribute(name).toString().isEmpty() ? 0 : 1;
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            QXmlStreamReader reader(cbp);
+            while (!reader.atEnd()) {
+                reader.readNext();
+                if (!reader.isStartElement())
+                    continue;
+                foreach (const char *name, attributeNames) {
+                    const QLatin1String attributeName(name);
+                    if (reader.attributes().hasAttribute(attributeName))
+                        strings += reader.attributes().value(attributeName).toString().isEmpty() ? 0 : 1;
+                }
+            }
+        }
+    }
+    QVERIFY(strings > 0);
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QString>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// A string in the buffer of a CMakeCbpScanner. XML entities are only decoded by toString().
+class CbpStringRef
+{
+public:
+    CbpStringRef() = default;
+    CbpStringRef(const char *data, int size) : m_data(data), m_size(size) { }
+
+    const char *data() const { return m_data; }
+    int size() const { return m_size; }
+    bool isNull() const { return !m_data; }
+    bool isEmpty() const { return m_size == 0; }
+
+    bool operator==(const char *latin1) const;
+    bool operator!=(const char *latin1) const { return !(*this == latin1); }
+
+    QString toString() const;
+
+private:
+    const char *m_data = nullptr;
+    int m_size = 0;
+};
+
+// Splits a Code::Blocks project file into start and end elements, without copying anything.
+// This is not a general XML parser: Text, comments, CDATA sections, processing instructions
+// and document type declarations are skipped, and attributes are only looked at when asked
+// for. A self-closing element is reported as a start element followed by an end element.
+class CMakeCbpScanner
+{
+public:
+    enum TokenType {
+        NoToken,
+        StartElement,
+        EndElement,
+        EndDocument,
+        Invalid
+    };
+
+    CMakeCbpScanner(const char *data, qint64 size);
+
+    TokenType readNext();
+    TokenType tokenType() const { return m_tokenType; }
+    bool atEnd() const { return m_tokenType == EndDocument || m_tokenType == Invalid; }
+    bool hasError() const { return m_tokenType == Invalid; }
+    bool isStartElement() const { return m_tokenType == StartElement; }
+    bool isEndElement() const { return m_tokenType == EndElement; }
+
+    CbpStringRef name() const { return m_name; }
+
+    // Only valid for start elements. A missing attribute is a null string.
+    CbpStringRef attribute(const char *name) const;
+    bool hasAttribute(const char *name) const { return !attribute(name).isNull(); }
+
+private:
+    TokenType setInvalid();
+
+    const char *m_pos;
+    const char *m_end;
+    TokenType m_tokenType = NoToken;
+    CbpStringRef m_name;
+    const char *m_attributesBegin = nullptr;
+    const char *m_attributesEnd = nullptr;
+    bool m_pendingEndElement = false;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,240 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakecompilercache.h"
+
+#include <utils/algorithm.h>
+#include <utils/synchronousprocess.h>
+
+#include <QRegularExpression>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+CMakeCompilerCache::Statistics CMakeCompilerCache::Statistics::operator-(const Statistics &other) const
+{
+    Statistics result;
+    if (isValid() && other.isValid()) {
+        result.hits = hits - other.hits;
+        result.misses = misses - other.misses;
+    }
+    return result;
+}
+
+QList<Utils::FileName> CMakeCompilerCache::detectLaunchers(const Utils::Environment &env)
+{
+    QList<Utils::FileName> result;
+    foreach (const QString &name, QStringList() << QLatin1String("ccache") << QLatin1String("sccache")) {
+        const Utils::FileName launcher = env.searchInPath(name);
+        if (!launcher.isEmpty())
+            result.append(launcher);
+    }
+    return result;
+}
+
+CMakeCompilerCache::Statistics CMakeCompilerCache::statistics(const Utils::FileName &launcher,
+                                                              const Utils::Environment &env)
+{
+    Utils::SynchronousProcess process;
+    process.setTimeoutS(2);
+    process.setFlags(Utils::SynchronousProcess::UnixTerminalDisabled);
+    Utils::Environment englishEnv = env;
+    Utils::Environment::setupEnglishOutput(&englishEnv);
+    process.setProcessEnvironment(englishEnv.toProcessEnvironment());
+    process.setTimeOutMessageBoxEnabled(false);
+
+    // ccache before 3.7 has no --print-stats, only the human readable -s
+    QStringList argumentLists;
+    if (launcher.fileName().startsWith(QLatin1String("sccache")))
+        argumentLists << QLatin1String("--show-stats");
+    else
+        argumentLists << QLatin1String("--print-stats") << QLatin1String("-s");
+
+    foreach (const QString &argument, argumentLists) {
+        const Utils::SynchronousProcessResponse response
+                = process.run(launcher.toString(), QStringList(argument));
+        if (response.result != Utils::SynchronousProcessResponse::Finished)
+            continue;
+        const Statistics statistics = parseStatistics(response.stdOut);
+        if (statistics.isValid())
+            return statistics;
+    }
+    return Statistics();
+}
+
+// Understands the output of "ccache --print-stats" (3.7: cache_hit_direct, 4.x: direct_cache_hit),
+// "ccache -s" ("cache hit (direct)   12") and "sccache --show-stats" ("Cache hits   12").
+CMakeCompilerCache::Statistics CMakeCompilerCache::parseStatistics(const QString &output)
+{
+    static const QRegularExpression line(QLatin1String("^\\s*([A-Za-z_ ()/+]*?)\\s+(\\d+)\\s*$"),
+                                         QRegularExpression::MultilineOption);
+    Statistics result;
+    QRegularExpressionMatchIterator it = line.globalMatch(output);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        const QString key = match.captured(1).toLower().replace(QLatin1Char(' '), QLatin1Char('_'));
+        const qint64 value = match.captured(2).toLongLong();
+        if (key == QLatin1String("cache_hit_direct") || key == QLatin1String("direct_cache_hit")
+                || key == QLatin1String("cache_hit_preprocessed")
+                || key == QLatin1String("preprocessed_cache_hit")
+                || key == QLatin1String("cache_hit_(direct)")
+                || key == QLatin1String("cache_hit_(preprocessed)")
+                || key == QLatin1String("cache_hits")) {
+            result.hits = qMax(result.hits, qint64(0)) + value;
+        } else if (key == QLatin1String("cache_miss") || key == QLatin1String("cache_misses")) {
+            result.misses = qMax(result.misses, qint64(0)) + value;
+        }
+    }
+    return result;
+}
+
+// Remembers which launcher Qt Creator set, so that it can tell it apart from one the user set
+static QByteArray injectedLauncherKey(const char *language)
+{
+    return QByteArray("QTC_CMAKE_") + language + "_COMPILER_LAUNCHER";
+}
+
+QStringList CMakeCompilerCache::configureArguments(const Utils::FileName &launcher,
+                                                   const CMakeConfig &config,
+                                                   const CMakeConfig &cache)
+{
+    QStringList arguments;
+    for (const char *language : {"C", "CXX"}) {
+        const QByteArray key = QByteArray("CMAKE_") + language + "_COMPILER_LAUNCHER";
+        const QByteArray injectedKey = injectedLauncherKey(language);
+        // A launcher in the configuration of the project wins over the one of the kit
+        if (Utils::anyOf(config, [&key](const CMakeConfigItem &item) { return item.key == key; }))
+            continue;
+
+        const QByteArray cached = CMakeConfigItem::valueOf(key, cache);
+        const QByteArray injected = CMakeConfigItem::valueOf(injectedKey, cache);
+        if (!cached.isEmpty() && cached != injected)
+            continue; // Set by the user
+
+        if (!launcher.isEmpty()) {
+            arguments << QString::fromLatin1("-D%1:FILEPATH=%2")
+                         .arg(QString::fromLatin1(key), launcher.toString())
+                      << QString::fromLatin1("-D%1:INTERNAL=%2")
+                         .arg(QString::fromLatin1(injectedKey), launcher.toString());
+        } else if (!injected.isEmpty()) {
+            arguments << QString::fromLatin1("-U") + QString::fromLatin1(key)
+                      << QString::fromLatin1("-U") + QString::fromLatin1(injectedKey);
+        }
+    }
+    return arguments;
+}
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+
+void CMakeProjectPlugin::testCMakeCompilerCacheStatistics_data()
+{
+    QTest::addColumn<QString>("output");
+    QTest::addColumn<qint64>("hits");
+    QTest::addColumn<qint64>("misses");
+
+    QTest::newRow("ccache 3.7 --print-stats")
+            << QString::fromLatin1("stats_zeroed_timestamp\t0\n"
+                                   "cache_hit_direct\t120\n"
+                                   "cache_hit_preprocessed\t30\n"
+                                   "cache_miss\t50\n"
+                                   "called_for_link\t4\n")
+            << qint64(150) << qint64(50);
+    QTest::newRow("ccache 4 --print-stats")
+            << QString::fromLatin1("direct_cache_hit\t7\n"
+                                   "direct_cache_miss\t3\n"
+                                   "preprocessed_cache_hit\t1\n"
+                                   "preprocessed_cache_miss\t2\n"
+                                   "cache_miss\t2\n")
+            << qint64(8) << qint64(2);
+    QTest::newRow("ccache -s")
+            << QString::fromLatin1("cache directory                     /home/user/.ccache\n"
+                                   "cache hit (direct)                    10\n"
+                                   "cache hit (preprocessed)               5\n"
+                                   "cache miss                             3\n"
+                                   "cache hit rate                     83.33 %\n")
+            << qint64(15) << qint64(3);
+    QTest::newRow("sccache --show-stats")
+            << QString::fromLatin1("Compile requests                     20\n"
+                                   "Cache hits                           12\n"
+                                   "Cache hits (C/C++)                   12\n"
+                                   "Cache misses                          8\n"
+                                   "Cache misses (C/C++)                  8\n")
+            << qint64(12) << qint64(8);
+    QTest::newRow("no statistics") << QString::fromLatin1("ccache: invalid option") << qint64(-1) << qint64(-1);
+}
+
+void CMakeProjectPlugin::testCMakeCompilerCacheStatistics()
+{
+    QFETCH(QString, output);
+    QFETCH(qint64, hits);
+    QFETCH(qint64, misses);
+
+    const CMakeCompilerCache::Statistics statistics = CMakeCompilerCache::parseStatistics(output);
+    QCOMPARE(statistics.hits, hits);
+    QCOMPARE(statistics.misses, misses);
+}
+
+void CMakeProjectPlugin::testCMakeCompilerCacheConfigureArguments()
+{
+    const Utils::FileName ccache = Utils::FileName::fromString(QString::fromLatin1("/usr/bin/ccache"));
+    const CMakeConfig none;
+    const CMakeConfig injected = CMakeConfig()
+            << CMakeConfigItem("CMAKE_C_COMPILER_LAUNCHER", "/usr/bin/ccache")
+            << CMakeConfigItem("QTC_CMAKE_C_COMPILER_LAUNCHER", "/usr/bin/ccache")
+            << CMakeConfigItem("CMAKE_CXX_COMPILER_LAUNCHER", "/usr/bin/ccache")
+            << CMakeConfigItem("QTC_CMAKE_CXX_COMPILER_LAUNCHER", "/usr/bin/ccache");
+    const CMakeConfig own = CMakeConfig()
+            << CMakeConfigItem("CMAKE_C_COMPILER_LAUNCHER", "/opt/distcc")
+            << CMakeConfigItem("CMAKE_CXX_COMPILER_LAUNCHER", "/opt/distcc");
+
+    const QStringList setArguments = QStringList()
+            << QString::fromLatin1("-DCMAKE_C_COMPILER_LAUNCHER:FILEPATH=/usr/bin/ccache")
+            << QString::fromLatin1("-DQTC_CMAKE_C_COMPILER_LAUNCHER:INTERNAL=/usr/bin/ccache")
+            << QString::fromLatin1("-DCMAKE_CXX_COMPILER_LAUNCHER:FILEPATH=/usr/bin/ccache")
+            << QString::fromLatin1("-DQTC_CMAKE_CXX_COMPILER_LAUNCHER:INTERNAL=/usr/bin/ccache");
+    QCOMPARE(CMakeCompilerCache::configureArguments(ccache, none, none), setArguments);
+    QCOMPARE(CMakeCompilerCache::configureArguments(ccache, none, injected), setArguments);
+
+    // The launcher of the project wins, whether it is configured or only in the cache
+    QVERIFY(CMakeCompilerCache::configureArguments(ccache, own, none).isEmpty());
+    QVERIFY(CMakeCompilerCache::configureArguments(ccache, none, own).isEmpty());
+    QVERIFY(CMakeCompilerCache::configureArguments(Utils::FileName(), none, own).isEmpty());
+
+    // Switching the kit's compiler cache off removes the launcher that was set for it
+    QCOMPARE(CMakeCompilerCache::configureArguments(Utils::FileName(), none, injected),
+             QStringList() << QString::fromLatin1("-UCMAKE_C_COMPILER_LAUNCHER")
+                           << QString::fromLatin1("-UQTC_CMAKE_C_COMPILER_LAUNCHER")
+                           << QString::fromLatin1("-UCMAKE_CXX_COMPILER_LAUNCHER")
+                           << QString::fromLatin1("-UQTC_CMAKE_CXX_COMPILER_LAUNCHER"));
+    QVERIFY(CMakeCompilerCache::configureArguments(Utils::FileName(), none, none).isEmpty());
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,65 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "cmakeconfigitem.h"
+
+#include <utils/environment.h>
+#include <utils/fileutils.h>
+
+#include <QStringList>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// ccache or sccache, run by CMake as CMAKE_<LANG>_COMPILER_LAUNCHER
+class CMakeCompilerCache
+{
+public:
+    class Statistics
+    {
+    public:
+        bool isValid() const { return hits >= 0 && misses >= 0; }
+        Statistics operator-(const Statistics &other) const;
+
+        qint64 hits = -1;
+        qint64 misses = -1;
+    };
+
+    static QList<Utils::FileName> detectLaunchers(const Utils::Environment &env);
+
+    static Statistics statistics(const Utils::FileName &launcher, const Utils::Environment &env);
+    static Statistics parseStatistics(const QString &output);
+
+    // The -D and -U arguments that make CMake use launcher, or stop using the launcher it was
+    // told to use before, when launcher is empty. Launchers that the configuration or the
+    // cache of the project set otherwise are left alone.
+    static QStringList configureArguments(const Utils::FileName &launcher, const CMakeConfig &config,
+                                          const CMakeConfig &cache);
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,354 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakecompletionindex.h"
+
+#include <utils/algorithm.h>
+
+#include <QFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool isNameChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool isName(const QByteArray &word)
+{
+    return !word.isEmpty() && std::all_of(word.constBegin(), word.constEnd(), isNameChar);
+}
+
+const char *skipSpaces(const char *pos, const char *end)
+{
+    while (pos < end && isSpace(*pos))
+        ++pos;
+    return pos;
+}
+
+// "CMAKE_BUILD_TYPE" -> "cbt", nothing for names of one word
+QString initials(const QString &name)
+{
+    QString result;
+    bool atWordStart = true;
+    for (const QChar c : name) {
+        if (c == QLatin1Char('_')) {
+            atWordStart = true;
+        } else if (atWordStart) {
+            result.append(c.toLower());
+            atWordStart = false;
+        }
+    }
+    return result.size() > 1 ? result : QString();
+}
+
+} // namespace
+
+void CMakeCompletionIndex::addKeywords(const TextEditor::Keywords &keywords)
+{
+    foreach (const QString &variable, keywords.variables())
+        addVariable(variable);
+    const QStringList functions = keywords.functions();
+    foreach (const QString &function, functions)
+        addFunction(function, keywords.argsForFunction(function));
+    m_hasKeywords = m_hasKeywords || !functions.isEmpty();
+}
+
+void CMakeCompletionIndex::addCacheEntries(const CMakeConfig &configuration)
+{
+    foreach (const CMakeConfigItem &item, configuration) {
+        if (item.type != CMakeConfigItem::INTERNAL && item.type != CMakeConfigItem::STATIC)
+            addVariable(QString::fromUtf8(item.key));
+    }
+}
+
+// Only looks at the first line of a command, which is where the names are in practice
+void CMakeCompletionIndex::addDefinitions(const QByteArray &contents)
+{
+    const char *pos = contents.constData();
+    const char *const end = pos + contents.size();
+    while (pos < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(pos, '\n', size_t(end - pos)));
+        if (!lineEnd)
+            lineEnd = end;
+
+        const char *commandStart = skipSpaces(pos, lineEnd);
+        const char *commandEnd = commandStart;
+        while (commandEnd < lineEnd && isNameChar(*commandEnd))
+            ++commandEnd;
+        const char *open = skipSpaces(commandEnd, lineEnd);
+        pos = lineEnd + 1;
+        if (open == lineEnd || *open != '(')
+            continue;
+
+        const QByteArray command = QByteArray(commandStart, int(commandEnd - commandStart)).toLower();
+        const bool isFunction = command == "function" || command == "macro";
+        if (!isFunction && command != "option" && command != "set")
+            continue;
+
+        const char *argumentsEnd = open + 1;
+        while (argumentsEnd < lineEnd && *argumentsEnd != ')' && *argumentsEnd != '#')
+            ++argumentsEnd;
+        const QList<QByteArray> arguments
+                = QByteArray(open + 1, int(argumentsEnd - open - 1)).simplified().split(' ');
+        if (!isName(arguments.first()))
+            continue;
+
+        const QString name = QString::fromUtf8(arguments.first());
+        if (isFunction) {
+            QStringList parameters;
+            for (int i = 1; i < arguments.size(); ++i) {
+                if (isName(arguments.at(i)))
+                    parameters.append(QString::fromUtf8(arguments.at(i)));
+            }
+            addFunction(name, parameters);
+        } else {
+            addVariable(name);
+        }
+    }
+}
+
+void CMakeCompletionIndex::addCMakeFile(const Utils::FileName &fileName)
+{
+    QFile file(fileName.toString());
+    if (file.open(QIODevice::ReadOnly))
+        addDefinitions(file.readAll());
+}
+
+void CMakeCompletionIndex::addFunction(const QString &name, const QStringList &arguments)
+{
+    addName(name, true);
+    if (!arguments.isEmpty())
+        m_functionArgs.insert(name, arguments);
+}
+
+void CMakeCompletionIndex::addVariable(const QString &name)
+{
+    addName(name, false);
+}
+
+void CMakeCompletionIndex::addName(const QString &name, bool isFunction)
+{
+    if (name.isEmpty())
+        return;
+    Name entry;
+    entry.key = name.toLower();
+    entry.name = name;
+    entry.isFunction = isFunction;
+    m_names.append(entry);
+}
+
+void CMakeCompletionIndex::finish()
+{
+    std::sort(m_names.begin(), m_names.end(), [](const Name &a, const Name &b) {
+        if (a.key != b.key)
+            return a.key < b.key;
+        if (a.name != b.name)
+            return a.name < b.name;
+        return a.isFunction < b.isFunction;
+    });
+    m_names.erase(std::unique(m_names.begin(), m_names.end(), [](const Name &a, const Name &b) {
+        return a.name == b.name && a.isFunction == b.isFunction;
+    }), m_names.end());
+
+    m_initials.clear();
+    QStringList variables;
+    QStringList functions;
+    for (int i = 0; i < m_names.size(); ++i) {
+        const Name &entry = m_names.at(i);
+        const QString nameInitials = initials(entry.name);
+        if (!nameInitials.isEmpty())
+            m_initials.append(qMakePair(nameInitials, i));
+        (entry.isFunction ? functions : variables).append(entry.name);
+    }
+    std::sort(m_initials.begin(), m_initials.end());
+    m_all = TextEditor::Keywords(variables, functions, m_functionArgs);
+}
+
+TextEditor::Keywords CMakeCompletionIndex::keywords(const QString &prefix) const
+{
+    if (prefix.isEmpty())
+        return m_all;
+
+    const QString key = prefix.toLower();
+    QVector<int> found;
+    auto name = std::lower_bound(m_names.constBegin(), m_names.constEnd(), key,
+                                 [](const Name &entry, const QString &key) {
+        return entry.key < key;
+    });
+    for (; name != m_names.constEnd() && name->key.startsWith(key); ++name)
+        found.append(int(name - m_names.constBegin()));
+
+    auto initial = std::lower_bound(m_initials.constBegin(), m_initials.constEnd(), key,
+                                    [](const QPair<QString, int> &entry, const QString &key) {
+        return entry.first < key;
+    });
+    for (; initial != m_initials.constEnd() && initial->first.startsWith(key); ++initial)
+        found.append(initial->second);
+
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    QStringList variables;
+    QStringList functions;
+    foreach (int index, found) {
+        const Name &entry = m_names.at(index);
+        (entry.isFunction ? functions : variables).append(entry.name);
+    }
+    return TextEditor::Keywords(variables, functions, m_functionArgs);
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+void CMakeProjectPlugin::testCMakeCompletionIndex()
+{
+    CMakeCompletionIndex index;
+    index.addKeywords(TextEditor::Keywords(
+            QStringList() << QString::fromLatin1("CMAKE_BUILD_TYPE")
+                          << QString::fromLatin1("CMAKE_BINARY_DIR")
+                          << QString::fromLatin1("PROJECT_NAME"),
+            QStringList() << QString::fromLatin1("add_executable")
+                          << QString::fromLatin1("add_library")
+                          << QString::fromLatin1("set"),
+            QMap<QString, QStringList>()));
+    QVERIFY(index.hasKeywords());
+
+    index.addDefinitions(
+            "cmake_minimum_required(VERSION 3.5)\n"
+            "FUNCTION(add_plugin name)\n"
+            "  set(PLUGIN_SOURCES ${ARGN}) # sources\n"
+            "endfunction()\n"
+            "macro (add_plugin_test target SOURCES)\n"
+            "option(BUILD_TESTS \"Build the tests\" ON)\n"
+            "set(${name}_FILES a.cpp)\n"
+            "# set(COMMENTED_OUT ON)\n"
+            "set(\"QUOTED\" ON)\n"
+            "set(CMAKE_BUILD_TYPE Debug)");
+
+    CMakeConfig configuration;
+    configuration << CMakeConfigItem("WITH_DOCS", CMakeConfigItem::BOOL, "", "ON")
+                  << CMakeConfigItem("CMAKE_CACHEFILE_DIR", CMakeConfigItem::INTERNAL, "", "/tmp");
+    index.addCacheEntries(configuration);
+    index.finish();
+    QCOMPARE(index.size(), 11);
+
+    TextEditor::Keywords keywords = index.keywords(QString::fromLatin1("add_p"));
+    QCOMPARE(keywords.functions(), QStringList()
+             << QString::fromLatin1("add_plugin") << QString::fromLatin1("add_plugin_test"));
+    QVERIFY(keywords.variables().isEmpty());
+    QCOMPARE(keywords.argsForFunction(QString::fromLatin1("add_plugin")),
+             QStringList(QString::fromLatin1("name")));
+    QCOMPARE(keywords.argsForFunction(QString::fromLatin1("add_plugin_test")),
+             QStringList() << QString::fromLatin1("target") << QString::fromLatin1("SOURCES"));
+
+    keywords = index.keywords(QString::fromLatin1("cmake_b"));
+    QCOMPARE(keywords.variables(), QStringList()
+             << QString::fromLatin1("CMAKE_BINARY_DIR") << QString::fromLatin1("CMAKE_BUILD_TYPE"));
+
+    // By the first letters of the words, and the other way round
+    keywords = index.keywords(QString::fromLatin1("CBT"));
+    QCOMPARE(keywords.variables(), QStringList(QString::fromLatin1("CMAKE_BUILD_TYPE")));
+    keywords = index.keywords(QString::fromLatin1("pl"));
+    QCOMPARE(keywords.variables(), QStringList(QString::fromLatin1("PLUGIN_SOURCES")));
+    keywords = index.keywords(QString::fromLatin1("a"));
+    QCOMPARE(keywords.functions(), QStringList()
+             << QString::fromLatin1("add_executable") << QString::fromLatin1("add_library")
+             << QString::fromLatin1("add_plugin") << QString::fromLatin1("add_plugin_test"));
+
+    QVERIFY(index.keywords(QString::fromLatin1("COMMENTED")).variables().isEmpty());
+    QVERIFY(index.keywords(QString::fromLatin1("xyz")).functions().isEmpty());
+
+    keywords = index.keywords();
+    QCOMPARE(keywords.functions().size(), 5);
+    QCOMPARE(keywords.variables(), QStringList()
+             << QString::fromLatin1("BUILD_TESTS")
+             << QString::fromLatin1("CMAKE_BINARY_DIR")
+             << QString::fromLatin1("CMAKE_BUILD_TYPE")
+             << QString::fromLatin1("PLUGIN_SOURCES")
+             << QString::fromLatin1("PROJECT_NAME")
+             << QString::fromLatin1("WITH_DOCS"));
+}
+
+void CMakeProjectPlugin::testCMakeCompletionIndexBenchmark()
+{
+    // 40000 names of two to four words, as in a big project with all its cache entries
+    const char *const words[] = { "cmake", "build", "type", "qt", "plugin", "test", "source",
+                                  "dir", "with", "enable", "flags", "library", "path", "use" };
+    const int wordCount = int(sizeof(words) / sizeof(words[0]));
+    CMakeCompletionIndex index;
+    QStringList names;
+    for (int i = 0; i < 40000; ++i) {
+        QString name = QString::fromLatin1(words[i % wordCount]).toUpper();
+        for (int word = 1; word < 2 + i % 3; ++word)
+            name += QLatin1Char('_') + QString::fromLatin1(words[(i / (word * 7) + word) % wordCount]).toUpper();
+        name += QString::number(i);
+        names << name;
+        index.addVariable(name);
+    }
+    index.finish();
+
+    const QStringList prefixes = QStringList()
+            << QString::fromLatin1("CMAKE_B") << QString::fromLatin1("qt_pl")
+            << QString::fromLatin1("wep") << QString::fromLatin1("USE_LIBRARY_1");
+    foreach (const QString &prefix, prefixes) {
+        QStringList expected = Utils::filtered(names, [&prefix](const QString &name) {
+            return name.startsWith(prefix, Qt::CaseInsensitive)
+                    || initials(name).startsWith(prefix.toLower());
+        });
+        expected = Utils::filteredUnique(expected);
+        Utils::sort(expected);
+        QCOMPARE(index.keywords(prefix).variables(), expected);
+    }
+
+    QBENCHMARK {
+        foreach (const QString &prefix, prefixes)
+            index.keywords(prefix);
+    }
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#endif
@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "cmakeconfigitem.h"
+
+#include <texteditor/codeassist/keywordscompletionassist.h>
+#include <utils/fileutils.h>
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// The names the completion in CMake files offers: the keywords of cmake, the functions, macros,
+// options and variables defined in the CMake files of a project, and its cache entries.
+// Looking names up is a binary search, so that it stays fast with tens of thousands of them.
+class CMakeCompletionIndex
+{
+public:
+    void addKeywords(const TextEditor::Keywords &keywords);
+    void addCacheEntries(const CMakeConfig &configuration);
+    // What function(), macro(), option() and set() define in a CMakeLists.txt or .cmake file
+    void addDefinitions(const QByteArray &contents);
+    void addCMakeFile(const Utils::FileName &fileName);
+    void addFunction(const QString &name, const QStringList &arguments = QStringList());
+    void addVariable(const QString &name);
+
+    // Sorts what was added, needs to be called before anything is looked up
+    void finish();
+
+    bool hasKeywords() const { return m_hasKeywords; }
+    int size() const { return m_names.size(); }
+
+    // The names starting with prefix and those whose words start with its letters, so that
+    // "cbt" finds CMAKE_BUILD_TYPE. Case does not matter. All names for an empty prefix.
+    TextEditor::Keywords keywords(const QString &prefix = QString()) const;
+
+private:
+    class Name
+    {
+    public:
+        QString key; // lower case
+        QString name;
+        bool isFunction = false;
+    };
+
+    void addName(const QString &name, bool isFunction);
+
+    QVector<Name> m_names; // sorted by key
+    QVector<QPair<QString, int>> m_initials; // first letters of the words of a name -> name
+    QMap<QString, QStringList> m_functionArgs;
+    TextEditor::Keywords m_all;
+    bool m_hasKeywords = false;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
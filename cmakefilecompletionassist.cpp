@@ -24,6 +24,8 @@
 ****************************************************************************/
 
 #include "cmakefilecompletionassist.h"
+#include "cmakecompletionindex.h"
+#include "cmakeproject.h"
 #include "cmakeprojectconstants.h"
 #include "cmakeprojectmanager.h"
 #include "cmakesettingspage.h"
@@ -61,6 +63,19 @@ CMakeFileCompletionAssist::CMakeFileCompletionAssist() :
     KeywordsCompletionAssistProcessor(Keywords())
 {}
 
+// The part of the name that is being completed
+static QString prefixAtCursor(const AssistInterface *interface)
+{
+    int start = interface->position();
+    while (start > 0) {
+        const QChar c = interface->characterAt(start - 1);
+        if (!c.isLetterOrNumber() && c != QLatin1Char('_'))
+            break;
+        --start;
+    }
+    return interface->textAt(start, interface->position() - start);
+}
+
 IAssistProposal *CMakeFileCompletionAssist::perform(const AssistInterface *interface)
 {
     Keywords kw;
@@ -68,9 +83,15 @@ IAssistProposal *CMakeFileCompletionAssist::perform(const AssistInterface *inter
     if (!fileName.isEmpty() && QFileInfo(fileName).isFile()) {
         Project *p = SessionManager::projectForFile(Utils::FileName::fromString(fileName));
         if (p && p->activeTarget()) {
-            CMakeTool *cmake = CMakeKitInformation::cmakeTool(p->activeTarget()->kit());
-            if (cmake && cmake->isValid())
-                kw = cmake->keywords();
+            // Only the names matching what is typed are handed on, so that proposals do not
+            // get slower with the size of the project. This runs in a worker thread, so the
+            // index, which the project builds on the GUI thread, is all that is looked at.
+            auto cmakeProject = qobject_cast<CMakeProject *>(p);
+            const QSharedPointer<const CMakeCompletionIndex> index
+                    = cmakeProject ? cmakeProject->completionIndex()
+                                   : QSharedPointer<const CMakeCompletionIndex>();
+            if (index)
+                kw = index->keywords(prefixAtCursor(interface));
         }
     }
 
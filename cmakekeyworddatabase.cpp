@@ -0,0 +1,319 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakekeyworddatabase.h"
+
+#include <coreplugin/icore.h>
+
+#include <utils/algorithm.h>
+#include <utils/environment.h>
+#include <utils/synchronousprocess.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+const quint32 KEYWORDS_MAGIC = 0x43436b57; // "CCkW"
+const quint32 KEYWORDS_VERSION = 1;
+
+const int HELP_TIMEOUT = 30000; // ms, nobody waits for it
+
+QString runCMake(const Utils::FileName &executable, const QString &argument)
+{
+    QProcess cmake;
+    Utils::Environment env = Utils::Environment::systemEnvironment();
+    Utils::Environment::setupEnglishOutput(&env);
+    cmake.setProcessEnvironment(env.toProcessEnvironment());
+
+    cmake.start(executable.toString(), QStringList(argument));
+    if (!cmake.waitForFinished(HELP_TIMEOUT)) {
+        cmake.kill();
+        cmake.waitForFinished();
+        return QString();
+    }
+    if (cmake.exitStatus() != QProcess::NormalExit || cmake.exitCode() != 0)
+        return QString();
+    return Utils::SynchronousProcess::normalizeNewlines(
+                QString::fromLocal8Bit(cmake.readAllStandardOutput()));
+}
+
+QStringList parseDefinition(const QString &definition)
+{
+    QStringList result;
+    QString word;
+    bool ignoreWord = false;
+    QVector<QChar> braceStack;
+
+    foreach (const QChar &c, definition) {
+        if (c == QLatin1Char('[') || c == QLatin1Char('<') || c == QLatin1Char('(')) {
+            braceStack.append(c);
+            ignoreWord = false;
+        } else if (c == QLatin1Char(']') || c == QLatin1Char('>') || c == QLatin1Char(')')) {
+            if (braceStack.isEmpty() || braceStack.takeLast() == QLatin1Char('<'))
+                ignoreWord = true;
+        }
+
+        if (c == QLatin1Char(' ') || c == QLatin1Char('[') || c == QLatin1Char('<') || c == QLatin1Char('(')
+                || c == QLatin1Char(']') || c == QLatin1Char('>') || c == QLatin1Char(')')) {
+            if (!ignoreWord && !word.isEmpty()) {
+                if (result.isEmpty() || Utils::allOf(word, [](const QChar &c) { return c.isUpper() || c == QLatin1Char('_'); }))
+                    result.append(word);
+            }
+            word.clear();
+            ignoreWord = false;
+        } else {
+            word.append(c);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TextEditor::Keywords CMakeKeywordDatabase::keywords() const
+{
+    return TextEditor::Keywords(variables, functions, functionArgs);
+}
+
+CMakeKeywordDatabase CMakeKeywordDatabase::build(const Utils::FileName &executable)
+{
+    CMakeKeywordDatabase database;
+    database.functions = runCMake(executable, QLatin1String("--help-command-list"))
+            .split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    if (database.functions.isEmpty())
+        return database;
+
+    database.parseFunctionDetailsOutput(runCMake(executable, QLatin1String("--help-commands")));
+    database.variables
+            = parseVariableOutput(runCMake(executable, QLatin1String("--help-property-list")))
+            + parseVariableOutput(runCMake(executable, QLatin1String("--help-variable-list")));
+    database.variables = Utils::filteredUnique(database.variables);
+    Utils::sort(database.variables);
+    return database;
+}
+
+QString CMakeKeywordDatabase::fileName(const QString &cmakeVersion)
+{
+    QString version = cmakeVersion;
+    for (QChar &c : version) {
+        if (!c.isLetterOrNumber() && c != QLatin1Char('.') && c != QLatin1Char('-'))
+            c = QLatin1Char('_');
+    }
+    return Core::ICore::userResourcePath() + QLatin1String("/cmake/keywords-") + version
+            + QLatin1String(".bin");
+}
+
+bool CMakeKeywordDatabase::save(const QString &fileName) const
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << KEYWORDS_MAGIC << KEYWORDS_VERSION << functions << functionArgs << variables;
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool CMakeKeywordDatabase::load(const QString &fileName)
+{
+    // The completion wants the keywords as string lists, so they are read in one go
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != KEYWORDS_MAGIC
+            || version != KEYWORDS_VERSION) {
+        return false;
+    }
+
+    CMakeKeywordDatabase database;
+    stream >> database.functions >> database.functionArgs >> database.variables;
+    if (stream.status() != QDataStream::Ok || !database.isValid())
+        return false;
+
+    *this = database;
+    return true;
+}
+
+void CMakeKeywordDatabase::parseFunctionDetailsOutput(const QString &output)
+{
+    const QSet<QString> functionSet = functions.toSet();
+
+    bool expectDefinition = false;
+    QString currentDefinition;
+
+    const QStringList lines = output.split(QLatin1Char('\n'));
+    for (int i = 0; i < lines.count(); ++i) {
+        const QString line = lines.at(i);
+
+        if (line == QLatin1String("::")) {
+            expectDefinition = true;
+            continue;
+        }
+
+        if (expectDefinition) {
+            if (!line.startsWith(QLatin1Char(' ')) && !line.isEmpty()) {
+                expectDefinition = false;
+                QStringList words = parseDefinition(currentDefinition);
+                if (!words.isEmpty()) {
+                    const QString command = words.takeFirst();
+                    if (functionSet.contains(command)) {
+                        QStringList tmp = words + functionArgs[command];
+                        Utils::sort(tmp);
+                        functionArgs[command] = Utils::filteredUnique(tmp);
+                    }
+                }
+                if (!words.isEmpty() && functionSet.contains(words.at(0)))
+                    functionArgs[words.at(0)];
+                currentDefinition.clear();
+            } else {
+                currentDefinition.append(line.trimmed() + QLatin1Char(' '));
+            }
+        }
+    }
+}
+
+QStringList CMakeKeywordDatabase::parseVariableOutput(const QString &output)
+{
+    const QStringList variableList = output.split(QLatin1Char('\n'));
+    QStringList result;
+    foreach (const QString &v, variableList) {
+        if (v.contains(QLatin1String("<CONFIG>"))) {
+            const QString tmp = QString(v).replace(QLatin1String("<CONFIG>"), QLatin1String("%1"));
+            result << tmp.arg(QLatin1String("DEBUG")) << tmp.arg(QLatin1String("RELEASE"))
+                   << tmp.arg(QLatin1String("MINSIZEREL")) << tmp.arg(QLatin1String("RELWITHDEBINFO"));
+        } else if (v.contains(QLatin1String("<LANG>"))) {
+            const QString tmp = QString(v).replace(QLatin1String("<LANG>"), QLatin1String("%1"));
+            result << tmp.arg(QLatin1String("C")) << tmp.arg(QLatin1String("CXX"));
+        } else if (!v.contains(QLatin1Char('<')) && !v.contains(QLatin1Char('['))) {
+            result << v;
+        }
+    }
+    return result;
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+void CMakeProjectPlugin::testCMakeKeywordDatabase()
+{
+    CMakeKeywordDatabase database;
+    database.functions = QStringList()
+            << QString::fromLatin1("add_executable") << QString::fromLatin1("project");
+    database.parseFunctionDetailsOutput(QString::fromLatin1(
+            "add_executable\n"
+            "--------------\n"
+            "\n"
+            "::\n"
+            "\n"
+            "  add_executable(<name> [WIN32] [MACOSX_BUNDLE]\n"
+            "                 [EXCLUDE_FROM_ALL]\n"
+            "                 source1 [source2 ...])\n"
+            "\n"
+            "Adds an executable target.\n"
+            "\n"
+            "::\n"
+            "\n"
+            "  unknown_command(<name> [OPTION])\n"
+            "\n"
+            "The end.\n"));
+    QCOMPARE(database.functionArgs.keys(), QStringList(QString::fromLatin1("add_executable")));
+    QCOMPARE(database.functionArgs.value(QString::fromLatin1("add_executable")), QStringList()
+             << QString::fromLatin1("EXCLUDE_FROM_ALL")
+             << QString::fromLatin1("MACOSX_BUNDLE")
+             << QString::fromLatin1("WIN32"));
+
+    database.variables = CMakeKeywordDatabase::parseVariableOutput(QString::fromLatin1(
+            "CMAKE_<LANG>_FLAGS\n"
+            "CMAKE_BUILD_TYPE\n"
+            "CMAKE_POLICY_DEFAULT_CMP<NNNN>\n"
+            "MAP_IMPORTED_CONFIG_<CONFIG>"));
+    QCOMPARE(database.variables, QStringList()
+             << QString::fromLatin1("CMAKE_C_FLAGS")
+             << QString::fromLatin1("CMAKE_CXX_FLAGS")
+             << QString::fromLatin1("CMAKE_BUILD_TYPE")
+             << QString::fromLatin1("MAP_IMPORTED_CONFIG_DEBUG")
+             << QString::fromLatin1("MAP_IMPORTED_CONFIG_RELEASE")
+             << QString::fromLatin1("MAP_IMPORTED_CONFIG_MINSIZEREL")
+             << QString::fromLatin1("MAP_IMPORTED_CONFIG_RELWITHDEBINFO"));
+
+    QVERIFY(CMakeKeywordDatabase::fileName(QString::fromLatin1("3.7.0-rc1 (patched)"))
+            .endsWith(QLatin1String("/cmake/keywords-3.7.0-rc1__patched_.bin")));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/keywords/3.7.2.bin");
+    QVERIFY(database.save(fileName));
+
+    CMakeKeywordDatabase loaded;
+    QVERIFY(loaded.load(fileName));
+    QCOMPARE(loaded.functions, database.functions);
+    QCOMPARE(loaded.functionArgs, database.functionArgs);
+    QCOMPARE(loaded.variables, database.variables);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("not a keyword database");
+    file.close();
+    QVERIFY(!loaded.load(fileName));
+    QCOMPARE(loaded.functions, database.functions);
+    QVERIFY(!loaded.load(dir.path() + QLatin1String("/missing.bin")));
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#endif
@@ -0,0 +1,65 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <texteditor/codeassist/keywordscompletionassist.h>
+#include <utils/fileutils.h>
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// The commands, their arguments, the properties and the variables a cmake version knows, for
+// the completion in CMake files. Asking cmake takes four processes and parsing megabytes of help
+// text, so it is done once per version in a worker thread. The result is kept in a versioned
+// file, which later sessions read instead.
+class CMakeKeywordDatabase
+{
+public:
+    QStringList functions;
+    QMap<QString, QStringList> functionArgs;
+    QStringList variables;
+
+    bool isValid() const { return !functions.isEmpty(); }
+    TextEditor::Keywords keywords() const;
+
+    // Runs cmake, so better call it from a worker thread
+    static CMakeKeywordDatabase build(const Utils::FileName &executable);
+
+    static QString fileName(const QString &cmakeVersion);
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+    // For the output of "cmake --help-commands" and of the property and variable lists
+    void parseFunctionDetailsOutput(const QString &output);
+    static QStringList parseVariableOutput(const QString &output);
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -25,6 +25,7 @@
 
 #include "cmakeprojectconstants.h"
 #include "cmakekitconfigwidget.h"
+#include "cmakecompilercache.h"
 #include "cmakekitinformation.h"
 #include "cmaketoolmanager.h"
 #include "cmaketool.h"
@@ -245,7 +246,10 @@ void CMakeGeneratorKitConfigWidget::refresh()
         m_currentTool = tool;
         m_comboBox->clear();
         m_comboBox->addItem(tr("<Use Default Generator>"), QString());
-        if (tool && tool->isValid()) {
+        // Filled in on the kit update that follows the validation of the tool
+        if (tool && tool->isValidationPending()) {
+            m_currentTool = nullptr;
+        } else if (tool && tool->isValid()) {
             foreach (const QString &g, tool->supportedGenerators())
                 m_comboBox->addItem(g, g);
         }
@@ -391,5 +395,78 @@ void CMakeConfigurationKitConfigWidget::acceptChangesDialog()
     closeChangesDialog();
 }
 
+// --------------------------------------------------------------------
+// CMakeCompilerCacheKitConfigWidget:
+// --------------------------------------------------------------------
+
+CMakeCompilerCacheKitConfigWidget::CMakeCompilerCacheKitConfigWidget(Kit *kit,
+                                                                     const KitInformation *ki) :
+    KitConfigWidget(kit, ki),
+    m_comboBox(new QComboBox)
+{
+    m_comboBox->setToolTip(toolTip());
+
+    refresh();
+    connect(m_comboBox, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, [this](int idx) {
+                m_ignoreChange = true;
+                CMakeCompilerCacheKitInformation::setLauncher(
+                            m_kit, Utils::FileName::fromString(m_comboBox->itemData(idx).toString()));
+                m_ignoreChange = false;
+            });
+}
+
+CMakeCompilerCacheKitConfigWidget::~CMakeCompilerCacheKitConfigWidget()
+{
+    delete m_comboBox;
+}
+
+QString CMakeCompilerCacheKitConfigWidget::displayName() const
+{
+    return tr("Compiler Cache:");
+}
+
+void CMakeCompilerCacheKitConfigWidget::makeReadOnly()
+{
+    m_comboBox->setEnabled(false);
+}
+
+void CMakeCompilerCacheKitConfigWidget::refresh()
+{
+    if (m_ignoreChange)
+        return;
+
+    Utils::Environment env = Utils::Environment::systemEnvironment();
+    m_kit->addToEnvironment(env);
+    const Utils::FileName current = CMakeCompilerCacheKitInformation::launcher(m_kit);
+
+    const bool wasBlocked = m_comboBox->blockSignals(true);
+    m_comboBox->clear();
+    m_comboBox->addItem(tr("<No Compiler Cache>"), QString());
+    QList<Utils::FileName> launchers = CMakeCompilerCache::detectLaunchers(env);
+    if (!current.isEmpty() && !launchers.contains(current))
+        launchers.append(current);
+    foreach (const Utils::FileName &launcher, launchers)
+        m_comboBox->addItem(launcher.toUserOutput(), launcher.toString());
+    m_comboBox->setCurrentIndex(m_comboBox->findData(current.toString()));
+    m_comboBox->blockSignals(wasBlocked);
+}
+
+QWidget *CMakeCompilerCacheKitConfigWidget::mainWidget() const
+{
+    return m_comboBox;
+}
+
+QWidget *CMakeCompilerCacheKitConfigWidget::buttonWidget() const
+{
+    return nullptr;
+}
+
+QString CMakeCompilerCacheKitConfigWidget::toolTip() const
+{
+    return tr("ccache or sccache found in the PATH of the kit. CMake runs the compilers through it "
+              "when it is not already set up with CMAKE_&lt;LANG&gt;_COMPILER_LAUNCHER.");
+}
+
 } // namespace Internal
 } // namespace CMakeProjectManager
@@ -134,5 +134,29 @@ private:
     QPlainTextEdit *m_editor = nullptr;
 };
 
+// --------------------------------------------------------------------
+// CMakeCompilerCacheKitConfigWidget:
+// --------------------------------------------------------------------
+
+class CMakeCompilerCacheKitConfigWidget : public ProjectExplorer::KitConfigWidget
+{
+    Q_OBJECT
+public:
+    CMakeCompilerCacheKitConfigWidget(ProjectExplorer::Kit *kit, const ProjectExplorer::KitInformation *ki);
+    ~CMakeCompilerCacheKitConfigWidget() override;
+
+    // KitConfigWidget interface
+    QString displayName() const override;
+    void makeReadOnly() override;
+    void refresh() override;
+    QWidget *mainWidget() const override;
+    QWidget *buttonWidget() const override;
+    QString toolTip() const override;
+
+private:
+    bool m_ignoreChange = false;
+    QComboBox *m_comboBox;
+};
+
 } // namespace Internal
 } // namespace CMakeProjectManager
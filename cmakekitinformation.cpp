@@ -32,6 +32,7 @@
 #include <projectexplorer/toolchain.h>
 #include <projectexplorer/kit.h>
 #include <projectexplorer/kitinformation.h>
+#include <projectexplorer/kitmanager.h>
 #include <qtsupport/qtkitinformation.h>
 #include <projectexplorer/projectexplorerconstants.h>
 
@@ -146,6 +147,18 @@ CMakeGeneratorKitInformation::CMakeGeneratorKitInformation()
     setObjectName(QLatin1String("CMakeGeneratorKitInformation"));
     setId(GENERATOR_ID);
     setPriority(19000);
+
+    // The generators of a tool are only known once it was validated in the background
+    connect(CMakeToolManager::instance(), &CMakeToolManager::cmakeUpdated,
+            this, [this](const Core::Id &id) {
+        foreach (Kit *k, KitManager::kits()) {
+            const CMakeTool *tool = CMakeKitInformation::cmakeTool(k);
+            if (!tool || tool->id() != id || tool->isValidationPending())
+                continue;
+            fix(k);
+            KitManager::notifyAboutUpdate(k);
+        }
+    });
 }
 
 QString CMakeGeneratorKitInformation::generator(const Kit *k)
@@ -173,7 +186,7 @@ QString CMakeGeneratorKitInformation::generatorArgument(const Kit *k)
 QVariant CMakeGeneratorKitInformation::defaultValue(const Kit *k) const
 {
     CMakeTool *tool = CMakeKitInformation::cmakeTool(k);
-    if (!tool)
+    if (!tool || tool->isValidationPending())
         return QString();
     QStringList known = tool->supportedGenerators();
     auto it = std::find_if(known.constBegin(), known.constEnd(),
@@ -217,7 +230,7 @@ QList<Task> CMakeGeneratorKitInformation::validate(const Kit *k) const
     QString generator = CMakeGeneratorKitInformation::generator(k);
 
     QList<Task> result;
-    if (tool) {
+    if (tool && !tool->isValidationPending()) {
         if (!tool->isValid()) {
             result << Task(Task::Warning, tr("CMake Tool is unconfigured, CMake generator will be ignored."),
                            Utils::FileName(), -1, Core::Id(Constants::TASK_CATEGORY_BUILDSYSTEM));
@@ -247,7 +260,7 @@ void CMakeGeneratorKitInformation::fix(Kit *k)
     const CMakeTool *tool = CMakeKitInformation::cmakeTool(k);
     const QString generator = CMakeGeneratorKitInformation::generator(k);
 
-    if (!tool)
+    if (!tool || tool->isValidationPending())
         return;
     QStringList known = tool->supportedGenerators();
     if (generator.isEmpty() || !known.contains(generator))
@@ -425,4 +438,73 @@ KitConfigWidget *CMakeConfigurationKitInformation::createConfigWidget(Kit *k) co
     return new Internal::CMakeConfigurationKitConfigWidget(k, this);
 }
 
+// --------------------------------------------------------------------
+// CMakeCompilerCacheKitInformation:
+// --------------------------------------------------------------------
+
+static const char COMPILER_CACHE_ID[] = "CMake.CompilerCacheKitInformation";
+
+CMakeCompilerCacheKitInformation::CMakeCompilerCacheKitInformation()
+{
+    setObjectName(QLatin1String("CMakeCompilerCacheKitInformation"));
+    setId(COMPILER_CACHE_ID);
+    setPriority(17000);
+}
+
+Utils::FileName CMakeCompilerCacheKitInformation::launcher(const Kit *k)
+{
+    if (!k)
+        return Utils::FileName();
+    return Utils::FileName::fromString(k->value(COMPILER_CACHE_ID).toString());
+}
+
+void CMakeCompilerCacheKitInformation::setLauncher(Kit *k, const Utils::FileName &launcher)
+{
+    if (!k)
+        return;
+    k->setValue(COMPILER_CACHE_ID, launcher.toString());
+}
+
+QVariant CMakeCompilerCacheKitInformation::defaultValue(const Kit *k) const
+{
+    // Off unless chosen, the cache changes the compiler command lines
+    Q_UNUSED(k);
+    return QString();
+}
+
+QList<Task> CMakeCompilerCacheKitInformation::validate(const Kit *k) const
+{
+    QList<Task> result;
+    const Utils::FileName cache = launcher(k);
+    if (!cache.isEmpty() && !cache.toFileInfo().isExecutable()) {
+        result << Task(Task::Warning, tr("The compiler cache \"%1\" does not exist and will be ignored.")
+                       .arg(cache.toUserOutput()),
+                       Utils::FileName(), -1, Core::Id(Constants::TASK_CATEGORY_BUILDSYSTEM));
+    }
+    return result;
+}
+
+void CMakeCompilerCacheKitInformation::setup(Kit *k)
+{
+    if (!k->hasValue(COMPILER_CACHE_ID))
+        setLauncher(k, Utils::FileName::fromString(defaultValue(k).toString()));
+}
+
+void CMakeCompilerCacheKitInformation::fix(Kit *k)
+{
+    Q_UNUSED(k);
+}
+
+KitInformation::ItemList CMakeCompilerCacheKitInformation::toUserOutput(const Kit *k) const
+{
+    const Utils::FileName cache = launcher(k);
+    return ItemList() << qMakePair(tr("Compiler Cache"),
+                                   cache.isEmpty() ? tr("<No Compiler Cache>") : cache.toUserOutput());
+}
+
+KitConfigWidget *CMakeCompilerCacheKitInformation::createConfigWidget(Kit *k) const
+{
+    return new Internal::CMakeCompilerCacheKitConfigWidget(k, this);
+}
+
 } // namespace CMakeProjectManager
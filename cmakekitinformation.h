@@ -31,6 +31,8 @@
 
 #include <projectexplorer/kitmanager.h>
 
+#include <utils/fileutils.h>
+
 namespace CMakeProjectManager {
 
 class CMakeTool;
@@ -97,4 +99,23 @@ public:
     ProjectExplorer::KitConfigWidget *createConfigWidget(ProjectExplorer::Kit *k) const override;
 };
 
+class CMAKE_EXPORT CMakeCompilerCacheKitInformation : public ProjectExplorer::KitInformation
+{
+    Q_OBJECT
+public:
+    CMakeCompilerCacheKitInformation();
+
+    // ccache or sccache, empty if none
+    static Utils::FileName launcher(const ProjectExplorer::Kit *k);
+    static void setLauncher(ProjectExplorer::Kit *k, const Utils::FileName &launcher);
+
+    // KitInformation interface
+    QVariant defaultValue(const ProjectExplorer::Kit *k) const override;
+    QList<ProjectExplorer::Task> validate(const ProjectExplorer::Kit *k) const override;
+    void setup(ProjectExplorer::Kit *k) override;
+    void fix(ProjectExplorer::Kit *k) override;
+    ItemList toUserOutput(const ProjectExplorer::Kit *k) const override;
+    ProjectExplorer::KitConfigWidget *createConfigWidget(ProjectExplorer::Kit *k) const override;
+};
+
 } // namespace CMakeProjectManager
@@ -102,13 +102,12 @@ void CMakeLocatorFilter::accept(Core::LocatorFilterEntry selection) const
         return;
 
     // Change the make step to build only the given target
-    QString oldTarget = buildStep->buildTarget();
-    buildStep->clearBuildTargets();
+    const QStringList oldTargets = buildStep->buildTargets();
     buildStep->setBuildTarget(selection.displayName);
 
     // Build
     ProjectExplorerPlugin::buildProject(cmakeProject);
-    buildStep->setBuildTarget(oldTarget);
+    buildStep->setBuildTargets(oldTargets);
 }
 
 void CMakeLocatorFilter::refresh(QFutureInterface<void> &future)
@@ -29,31 +29,54 @@
 
 #include <projectexplorer/projectexplorerconstants.h>
 
+#include <QPair>
+
 using namespace CMakeProjectManager;
 using namespace Internal;
 using namespace ProjectExplorer;
 
-const char COMMON_ERROR_PATTERN[] = "^CMake Error at (.*):([0-9]*) \\((.*)\\):";
-const char NEXT_SUBERROR_PATTERN[] = "^CMake Error in (.*):";
-const char LOCATION_LINE_PATTERN[] = ":(\\d+):(?:(\\d+))?$";
+namespace {
+
+const QLatin1String COMMON_ERROR_PREFIX("CMake Error at "); // <file>:<line> (<command>):
+const QLatin1String NEXT_SUBERROR_PREFIX("CMake Error in "); // <file>:
+const QLatin1String COMMON_WARNING_PREFIX("CMake Warning at "); // <file>:<line> (<command>):
+const QLatin1String DEV_WARNING_PREFIX("CMake Warning (dev) at "); // <file>:<line> (<command>):
+const QLatin1String CMAKE_ERROR_PREFIX("CMake Error: ");
+const QLatin1String TRIPLE_LINE_ERROR_SUFFIX("in cmake code at");
+
+int rightTrimmedLength(const QString &line)
+{
+    int length = line.size();
+    while (length > 0 && line.at(length - 1).isSpace())
+        --length;
+    return length;
+}
+
+int skipDigits(const QStringRef &text, int pos)
+{
+    while (pos < text.size() && text.at(pos).isDigit())
+        ++pos;
+    return pos;
+}
 
-CMakeParser::CMakeParser()
+// Positions in a QStringRef made by leftRef() are positions in the string it refers to
+QString copy(const QStringRef &text, int pos, int length)
 {
-    m_commonError.setPattern(QLatin1String(COMMON_ERROR_PATTERN));
-    m_commonError.setMinimal(true);
-    QTC_CHECK(m_commonError.isValid());
+    return text.string()->mid(pos, length);
+}
+
+} // namespace
 
-    m_nextSubError.setPattern(QLatin1String(NEXT_SUBERROR_PATTERN));
-    m_nextSubError.setMinimal(true);
-    QTC_CHECK(m_nextSubError.isValid());
+CMakeParser::CMakeParser() = default;
 
-    m_locationLine.setPattern(QLatin1String(LOCATION_LINE_PATTERN));
-    QTC_CHECK(m_locationLine.isValid());
+void CMakeParser::setReportWarnings(bool report)
+{
+    m_reportWarnings = report;
 }
 
 void CMakeParser::stdError(const QString &line)
 {
-    QString trimmedLine = rightTrimmed(line);
+    const QStringRef trimmedLine = line.leftRef(rightTrimmedLength(line));
 
     switch (m_expectTripleLineErrorData) {
     case NONE:
@@ -67,30 +90,28 @@ void CMakeParser::stdError(const QString &line)
         if (m_skippedFirstEmptyLine)
             m_skippedFirstEmptyLine = false;
 
-        if (m_commonError.indexIn(trimmedLine) != -1) {
-            m_lastTask = Task(Task::Error, QString(), Utils::FileName::fromUserInput(m_commonError.cap(1)),
-                              m_commonError.cap(2).toInt(), Constants::TASK_CATEGORY_BUILDSYSTEM);
-            m_lines = 1;
+        if (trimmedLine.startsWith(QLatin1Char('C')) && parseErrorStart(trimmedLine))
             return;
-        } else if (m_nextSubError.indexIn(trimmedLine) != -1) {
-            m_lastTask = Task(Task::Error, QString(), Utils::FileName::fromUserInput(m_nextSubError.cap(1)), -1,
-                              Constants::TASK_CATEGORY_BUILDSYSTEM);
-            m_lines = 1;
-            return;
-        } else if (trimmedLine.startsWith(QLatin1String("  ")) && !m_lastTask.isNull()) {
+        if (trimmedLine.startsWith(QLatin1String("  ")) && !m_lastTask.isNull()) {
             if (!m_lastTask.description.isEmpty())
                 m_lastTask.description.append(QLatin1Char(' '));
-            m_lastTask.description.append(trimmedLine.trimmed());
+            int start = 0;
+            while (trimmedLine.at(start).isSpace())
+                ++start;
+            m_lastTask.description.append(line.midRef(start, trimmedLine.size() - start));
             ++m_lines;
             return;
-        } else if (trimmedLine.endsWith(QLatin1String("in cmake code at"))) {
+        }
+        if (trimmedLine.endsWith(TRIPLE_LINE_ERROR_SUFFIX)) {
             m_expectTripleLineErrorData = LINE_LOCATION;
             doFlush();
             m_lastTask = Task(trimmedLine.contains(QLatin1String("Error")) ? Task::Error : Task::Warning,
                               QString(), Utils::FileName(), -1, Constants::TASK_CATEGORY_BUILDSYSTEM);
             return;
-        } else if (trimmedLine.startsWith("CMake Error: ")) {
-            m_lastTask = Task(Task::Error, trimmedLine.mid(13),
+        }
+        if (trimmedLine.startsWith(CMAKE_ERROR_PREFIX)) {
+            m_lastTask = Task(Task::Error, copy(trimmedLine, CMAKE_ERROR_PREFIX.size(),
+                                   trimmedLine.size() - CMAKE_ERROR_PREFIX.size()),
                               Utils::FileName(), -1, Constants::TASK_CATEGORY_BUILDSYSTEM);
             m_lines = 1;
             return;
@@ -98,16 +119,11 @@ void CMakeParser::stdError(const QString &line)
         IOutputParser::stdError(line);
         return;
     case LINE_LOCATION:
-        {
-            QRegularExpressionMatch m = m_locationLine.match(trimmedLine);
-            QTC_CHECK(m.hasMatch());
-            m_lastTask.file = Utils::FileName::fromUserInput(trimmedLine.mid(0, m.capturedStart()));
-            m_lastTask.line = m.captured(1).toInt();
-            m_expectTripleLineErrorData = LINE_DESCRIPTION;
-        }
+        parseLocation(trimmedLine);
+        m_expectTripleLineErrorData = LINE_DESCRIPTION;
         return;
     case LINE_DESCRIPTION:
-        m_lastTask.description = trimmedLine;
+        m_lastTask.description = trimmedLine.toString();
         if (trimmedLine.endsWith(QLatin1Char('\"')))
             m_expectTripleLineErrorData = LINE_DESCRIPTION2;
         else {
@@ -124,6 +140,81 @@ void CMakeParser::stdError(const QString &line)
     }
 }
 
+// "CMake Error at <file>:<line> (<command>):" and "CMake Error in <file>:", likewise for
+// warnings. The file name ends at the first colon that is followed by what comes after it.
+bool CMakeParser::parseErrorStart(const QStringRef &line)
+{
+    static const QList<QPair<QLatin1String, Task::TaskType>> locationPrefixes = {
+        {COMMON_ERROR_PREFIX, Task::Error},
+        {COMMON_WARNING_PREFIX, Task::Warning},
+        {DEV_WARNING_PREFIX, Task::Warning}
+    };
+    for (const QPair<QLatin1String, Task::TaskType> &prefix : locationPrefixes) {
+        if (!line.startsWith(prefix.first))
+            continue;
+        if (prefix.second == Task::Warning && !m_reportWarnings) {
+            doFlush(); // The description of the warning is none of the previous task
+            return false;
+        }
+        const int fileStart = prefix.first.size();
+        for (int colon = line.indexOf(QLatin1Char(':'), fileStart); colon >= 0;
+             colon = line.indexOf(QLatin1Char(':'), colon + 1)) {
+            const int numberEnd = skipDigits(line, colon + 1);
+            if (numberEnd + 1 >= line.size() || line.at(numberEnd) != QLatin1Char(' ')
+                    || line.at(numberEnd + 1) != QLatin1Char('(')
+                    || line.indexOf(QLatin1String("):"), numberEnd + 2) < 0) {
+                continue;
+            }
+            // Warnings are not always followed by two empty lines
+            doFlush();
+            m_lastTask = Task(prefix.second, QString(),
+                              Utils::FileName::fromUserInput(copy(line, fileStart, colon - fileStart)),
+                              copy(line, colon + 1, numberEnd - colon - 1).toInt(),
+                              Constants::TASK_CATEGORY_BUILDSYSTEM);
+            m_lines = 1;
+            return true;
+        }
+        return false;
+    }
+    if (line.startsWith(NEXT_SUBERROR_PREFIX)) {
+        const int fileStart = NEXT_SUBERROR_PREFIX.size();
+        const int colon = line.indexOf(QLatin1Char(':'), fileStart);
+        if (colon >= 0) {
+            doFlush();
+            m_lastTask = Task(Task::Error, QString(),
+                              Utils::FileName::fromUserInput(copy(line, fileStart, colon - fileStart)),
+                              -1, Constants::TASK_CATEGORY_BUILDSYSTEM);
+            m_lines = 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "<file>:<line>:" or "<file>:<line>:<column>"
+void CMakeParser::parseLocation(const QStringRef &line)
+{
+    int pos = line.size();
+    while (pos > 0 && line.at(pos - 1).isDigit())
+        --pos;
+    const int lineEnd = pos - 1;
+    int lineStart = lineEnd;
+    if (lineEnd > 0 && line.at(lineEnd) == QLatin1Char(':')) {
+        while (lineStart > 0 && line.at(lineStart - 1).isDigit())
+            --lineStart;
+    }
+    const bool hasLocation = lineStart < lineEnd && lineStart > 0
+            && line.at(lineStart - 1) == QLatin1Char(':');
+    QTC_CHECK(hasLocation);
+    if (!hasLocation) {
+        m_lastTask.file = Utils::FileName::fromUserInput(line.toString());
+        m_lastTask.line = 0;
+        return;
+    }
+    m_lastTask.file = Utils::FileName::fromUserInput(copy(line, 0, lineStart - 1));
+    m_lastTask.line = copy(line, lineStart, lineEnd - lineStart).toInt();
+}
+
 void CMakeParser::doFlush()
 {
     if (m_lastTask.isNull())
@@ -139,6 +230,7 @@ void CMakeParser::doFlush()
 
 #include <projectexplorer/outputparser_test.h>
 
+#include <QRegExp>
 #include <QTest>
 
 void CMakeProjectPlugin::testCMakeParser_data()
@@ -251,6 +343,27 @@ void CMakeProjectPlugin::testCMakeParser_data()
                         Utils::FileName(), -1, categoryBuild))
             << QString();
 
+    QTest::newRow("developer warnings")
+            << QString::fromLatin1("CMake Warning (dev) at CMakeLists.txt:4 (project):\n"
+                                   "  Policy CMP0048 is not set: project() command manages VERSION\n"
+                                   "  variables.\n"
+                                   "This warning is for project developers.  Use -Wno-dev to suppress it.\n"
+                                   "\n"
+                                   "CMake Warning at src/CMakeLists.txt:12 (message):\n"
+                                   "  Deprecated option.\n\n")
+            << OutputParserTester::STDERR
+            << QString() << QString::fromLatin1("This warning is for project developers.  Use -Wno-dev to suppress it.\n")
+            << (QList<ProjectExplorer::Task>()
+                << Task(Task::Warning,
+                        QLatin1String("Policy CMP0048 is not set: project() command manages VERSION variables."),
+                        Utils::FileName::fromUserInput(QLatin1String("CMakeLists.txt")), 4,
+                        categoryBuild)
+                << Task(Task::Warning,
+                        QLatin1String("Deprecated option."),
+                        Utils::FileName::fromUserInput(QLatin1String("src/CMakeLists.txt")), 12,
+                        categoryBuild))
+            << QString();
+
     QTest::newRow("cmake warning")
             << QString::fromLatin1("Syntax Warning in cmake code at\n"
                                    "/test/path/CMakeLists.txt:9:15\n"
@@ -281,4 +394,94 @@ void CMakeProjectPlugin::testCMakeParser()
                           outputLines);
 }
 
+void CMakeProjectPlugin::testCMakeParserWithoutWarnings()
+{
+    OutputParserTester testbench;
+    auto parser = new CMakeParser;
+    parser->setReportWarnings(false);
+    testbench.appendOutputParser(parser);
+
+    const QString warnings = QString::fromLatin1("CMake Warning (dev) at CMakeLists.txt:4 (project):\n"
+                                                 "  Policy CMP0048 is not set.\n"
+                                                 "\n"
+                                                 "CMake Warning at src/CMakeLists.txt:12 (message):\n"
+                                                 "  Deprecated option.\n");
+    testbench.testParsing(warnings + QString::fromLatin1("CMake Error at CMakeLists.txt:7 (find_package):\n"
+                                                         "  Could not find Foo.\n"
+                                                         "\n\n"),
+                          OutputParserTester::STDERR,
+                          QList<Task>()
+                          << Task(Task::Error, QLatin1String("Could not find Foo."),
+                                  Utils::FileName::fromUserInput(QLatin1String("CMakeLists.txt")), 7,
+                                  Constants::TASK_CATEGORY_BUILDSYSTEM),
+                          QString(), warnings, QString());
+}
+
+void CMakeProjectPlugin::testCMakeParserBenchmark_data()
+{
+    QTest::addColumn<bool>("useParser");
+    QTest::newRow("CMakeParser") << true;
+    QTest::newRow("QRegExp") << false;
+}
+
+// Replays the stderr of a configure of a large project that was not written with -Wno-dev
+// in mind: a few real errors drowned in developer warnings.
+void CMakeProjectPlugin::testCMakeParserBenchmark()
+{
+    QFETCH(bool, useParser);
+
+    const char *warning[] = {
+        "CMake Warning (dev) at src/libs/%1/CMakeLists.txt:%2 (add_library):",
+        "  Policy CMP0028 is not set: Double colon in target name means ALIAS or",
+        "  IMPORTED target.  Run \"cmake --help-policy CMP0028\" for policy details.",
+        "  Use the cmake_policy command to set the policy and suppress this warning.",
+        "",
+        "  Target \"%1\" links to target \"Qt5::Core\" but the target was not found.",
+        "This warning is for project developers.  Use -Wno-dev to suppress it.",
+        "",
+    };
+    const char *error[] = {
+        "CMake Error at src/plugins/%1/CMakeLists.txt:%2 (add_subdirectory):",
+        "  add_subdirectory given source \"tests\" which is not an existing directory.",
+        "",
+        "",
+    };
+
+    const int lineCount = 100000;
+    QStringList log;
+    for (int i = 0; log.size() < lineCount; ++i) {
+        const bool isError = i % 50 == 49;
+        const int size = isError ? int(sizeof(error) / sizeof(error[0]))
+                                 : int(sizeof(warning) / sizeof(warning[0]));
+        for (int j = 0; j < size; ++j) {
+            const QString line = QString::fromLatin1(isError ? error[j] : warning[j]);
+            log << (j == 0 ? line.arg(QString::fromLatin1("module%1").arg(i)).arg(i % 400 + 1) : line);
+        }
+    }
+
+    if (useParser) {
+        CMakeParser parser;
+        QBENCHMARK {
+            foreach (const QString &line, log)
+                parser.stdError(line);
+            parser.flush();
+        }
+    } else {
+        // The matching that stdError did on every line before
+        QRegExp commonError(QLatin1String("^CMake Error at (.*):([0-9]*) \\((.*)\\):"));
+        commonError.setMinimal(true);
+        QRegExp nextSubError(QLatin1String("^CMake Error in (.*):"));
+        nextSubError.setMinimal(true);
+        int matches = 0;
+        QBENCHMARK {
+            foreach (const QString &line, log) {
+                const QString trimmedLine = IOutputParser::rightTrimmed(line);
+                if (commonError.indexIn(trimmedLine) != -1 || nextSubError.indexIn(trimmedLine) != -1)
+                    ++matches;
+            }
+        }
+        QVERIFY(matches > 0);
+    }
+}
+
 #endif
@@ -28,7 +28,7 @@
 #include <projectexplorer/ioutputparser.h>
 #include <projectexplorer/task.h>
 
-#include <QRegularExpression>
+#include <QStringRef>
 
 namespace CMakeProjectManager {
 namespace Internal {
@@ -41,19 +41,26 @@ public:
     explicit CMakeParser();
     void stdError(const QString &line) override;
 
+    // Builds rerun CMake, which repeats the warnings of the last configure run, so only
+    // configure runs report "CMake Warning at" and "CMake Warning (dev) at" as tasks.
+    void setReportWarnings(bool report);
+
 protected:
     void doFlush() override;
 
 private:
     enum TripleLineError { NONE, LINE_LOCATION, LINE_DESCRIPTION, LINE_DESCRIPTION2 };
 
+    // Most lines are none of ours, so they are recognized by their first characters
+    // without copying or matching regular expressions.
+    bool parseErrorStart(const QStringRef &line);
+    void parseLocation(const QStringRef &line);
+
     TripleLineError m_expectTripleLineErrorData = NONE;
 
     ProjectExplorer::Task m_lastTask;
-    QRegExp m_commonError;
-    QRegExp m_nextSubError;
-    QRegularExpression m_locationLine;
     bool m_skippedFirstEmptyLine = false;
+    bool m_reportWarnings = true;
     int m_lines = 0;
 };
 
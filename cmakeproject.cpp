@@ -27,6 +27,7 @@
 
 #include "builddirmanager.h"
 #include "cmakebuildstep.h"
+#include "cmakecompletionindex.h"
 #include "cmakekitinformation.h"
 #include "cmakeprojectconstants.h"
 #include "cmakeprojectnodes.h"
@@ -40,7 +41,7 @@
 #include <coreplugin/icore.h>
 #include <cpptools/cppmodelmanager.h>
 #include <cpptools/projectinfo.h>
-#include <cpptools/projectpartbuilder.h>
+#include <cpptools/projectfile.h>
 #include <projectexplorer/buildsteplist.h>
 #include <projectexplorer/buildtargetinfo.h>
 #include <projectexplorer/deployconfiguration.h>
@@ -62,13 +63,18 @@
 #include <extensionsystem/pluginmanager.h>
 #include <utils/algorithm.h>
 #include <utils/qtcassert.h>
+#include <utils/runextensions.h>
 #include <utils/stringutils.h>
 #include <utils/hostosinfo.h>
 
 #include <utils/mimetypes/mimedatabase.h>
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QLoggingCategory>
 #include <QTemporaryDir>
 
 using namespace ProjectExplorer;
@@ -151,10 +157,39 @@ CMakeProject::CMakeProject(CMakeManager *manager, const FileName &fileName)
     rootProjectNode()->setDisplayName(fileName.parentDir().fileName());
 
     connect(this, &CMakeProject::activeTargetChanged, this, &CMakeProject::handleActiveTargetChanged);
+    connect(&m_codeModelTargetsWatcher, &QFutureWatcher<CodeModelInput>::finished,
+            this, &CMakeProject::handleCodeModelTargets);
+    connect(&m_codeModelUpdateWatcher, &QFutureWatcher<CodeModelUpdate>::finished,
+            this, &CMakeProject::handleCppCodeModelUpdate);
+    connect(&m_completionIndexWatcher,
+            &QFutureWatcher<QSharedPointer<const CMakeCompletionIndex>>::finished, this, [this]() {
+        if (m_completionIndexWatcher.isCanceled()
+                || m_completionIndexWatcher.future().resultCount() == 0) {
+            return;
+        }
+        QMutexLocker locker(&m_completionIndexMutex);
+        m_completionIndex = m_completionIndexWatcher.result();
+    });
+    // The keyword database of cmake may have been built since the index was
+    connect(CMakeToolManager::instance(), &CMakeToolManager::cmakeUpdated,
+            this, [this](const Core::Id &id) {
+        CMakeTool *cmake = activeTarget() ? CMakeKitInformation::cmakeTool(activeTarget()->kit())
+                                          : nullptr;
+        const QSharedPointer<const CMakeCompletionIndex> index = completionIndex();
+        if (cmake && cmake->id() == id && (!index || !index->hasKeywords())
+                && !cmakeKeywords().functions().isEmpty()) {
+            updateCompletionIndex();
+        }
+    });
 }
 
 CMakeProject::~CMakeProject()
 {
+    // The code model update refers to the project, so it must not outlive it
+    m_codeModelTargetsWatcher.cancel();
+    m_codeModelTargetsWatcher.waitForFinished();
+    m_codeModelUpdateWatcher.cancel();
+    m_codeModelUpdateWatcher.waitForFinished();
     setRootProjectNode(nullptr);
     m_codeModelFuture.cancel();
     qDeleteAll(m_extraCompilers);
@@ -162,103 +197,6 @@ CMakeProject::~CMakeProject()
 
 
 
-QStringList CMakeProject::getCXXFlagsFor(const CMakeBuildTarget &buildTarget,
-                                         QHash<QString, QStringList> &cache)
-{
-    // check cache:
-    auto it = cache.constFind(buildTarget.title);
-    if (it != cache.constEnd())
-        return *it;
-
-    if (extractCXXFlagsFromMake(buildTarget, cache))
-        return cache.value(buildTarget.title);
-
-    if (extractCXXFlagsFromNinja(buildTarget, cache))
-        return cache.value(buildTarget.title);
-
-    cache.insert(buildTarget.title, QStringList());
-    return QStringList();
-}
-
-bool CMakeProject::extractCXXFlagsFromMake(const CMakeBuildTarget &buildTarget,
-                                           QHash<QString, QStringList> &cache)
-{
-    QString makeCommand = QDir::fromNativeSeparators(buildTarget.makeCommand);
-    int startIndex = makeCommand.indexOf(QLatin1Char('\"'));
-    int endIndex = makeCommand.indexOf(QLatin1Char('\"'), startIndex + 1);
-    if (startIndex != -1 && endIndex != -1) {
-        startIndex += 1;
-        QString makefile = makeCommand.mid(startIndex, endIndex - startIndex);
-        int slashIndex = makefile.lastIndexOf(QLatin1Char('/'));
-        makefile.truncate(slashIndex);
-        makefile.append(QLatin1String("/CMakeFiles/") + buildTarget.title + QLatin1String(".dir/flags.make"));
-        QFile file(makefile);
-        if (file.exists()) {
-            file.open(QIODevice::ReadOnly | QIODevice::Text);
-            QTextStream stream(&file);
-            while (!stream.atEnd()) {
-                QString line = stream.readLine().trimmed();
-                if (line.startsWith(QLatin1String("CXX_FLAGS ="))) {
-                    // Skip past =
-                    cache.insert(buildTarget.title,
-                                 line.mid(11).trimmed().split(QLatin1Char(' '),
-                                                              QString::SkipEmptyParts));
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-
-bool CMakeProject::extractCXXFlagsFromNinja(const CMakeBuildTarget &buildTarget,
-                                            QHash<QString, QStringList> &cache)
-{
-    Q_UNUSED(buildTarget)
-    if (!cache.isEmpty()) // We fill the cache in one go!
-        return false;
-
-    // Attempt to find build.ninja file and obtain FLAGS (CXX_FLAGS) from there if no suitable flags.make were
-    // found
-    // Get "all" target's working directory
-    QByteArray ninjaFile;
-    QString buildNinjaFile = QDir::fromNativeSeparators(buildTargets().at(0).workingDirectory);
-    buildNinjaFile += QLatin1String("/build.ninja");
-    QFile buildNinja(buildNinjaFile);
-    if (buildNinja.exists()) {
-        buildNinja.open(QIODevice::ReadOnly | QIODevice::Text);
-        ninjaFile = buildNinja.readAll();
-        buildNinja.close();
-    }
-
-    if (ninjaFile.isEmpty())
-        return false;
-
-    QTextStream stream(ninjaFile);
-    bool cxxFound = false;
-    const QString targetSignature = QLatin1String("# Object build statements for ");
-    QString currentTarget;
-
-    while (!stream.atEnd()) {
-        // 1. Look for a block that refers to the current target
-        // 2. Look for a build rule which invokes CXX_COMPILER
-        // 3. Return the FLAGS definition
-        QString line = stream.readLine().trimmed();
-        if (line.startsWith(QLatin1Char('#'))) {
-            if (line.startsWith(targetSignature)) {
-                int pos = line.lastIndexOf(QLatin1Char(' '));
-                currentTarget = line.mid(pos + 1);
-            }
-        } else if (!currentTarget.isEmpty() && line.startsWith(QLatin1String("build"))) {
-            cxxFound = line.indexOf(QLatin1String("CXX_COMPILER")) != -1;
-        } else if (cxxFound && line.startsWith(QLatin1String("FLAGS ="))) {
-            // Skip past =
-            cache.insert(currentTarget, line.mid(7).trimmed().split(QLatin1Char(' '), QString::SkipEmptyParts));
-        }
-    }
-    return !cache.isEmpty();
-}
-
 namespace {
 
 bool isValidDir(const QFileInfo &fileInfo)
@@ -299,6 +237,97 @@ void getFileList(const QDir &dir, const QString &projectRoot,
     }
 }
 
+template <typename HeaderPaths>
+qint64 headerPathsSize(const HeaderPaths &headerPaths)
+{
+    qint64 size = 0;
+    foreach (const auto &headerPath, headerPaths)
+        size += sizeof(headerPath) + headerPath.path.size() * sizeof(QChar);
+    return size;
+}
+
+// Most targets of a project share their include paths, defines and flags. The project parts
+// built for them hold identical copies of header paths and macros, which add up to a lot of
+// memory for big projects. ProjectPartInterner makes parts built from the same input share one
+// (implicitly shared, never modified) instance of that data.
+class ProjectPartInterner
+{
+public:
+    // Parts that are already in use by the code model are never modified, but later parts
+    // may share their data.
+    void intern(const QList<CppTools::ProjectPart::Ptr> &parts, bool partsInUse,
+                const QStringList &includePaths, const QByteArray &defines,
+                const QStringList &cFlags, const QStringList &cxxFlags)
+    {
+        const QByteArray flagsKey = cFlags.join(QLatin1Char(' ')).toUtf8() + '\n'
+                + cxxFlags.join(QLatin1Char(' ')).toUtf8();
+        // The system header paths of the toolchain depend on the flags (--sysroot, -nostdinc,
+        // -stdlib=, -target, ...), so they are part of the key
+        const QByteArray includeKey = includePaths.join(QLatin1Char('\n')).toUtf8() + '\n'
+                + flagsKey;
+
+        foreach (const CppTools::ProjectPart::Ptr &part, parts) {
+            ++m_totalParts;
+            const QByteArray languageKey = QByteArray::number(part->languageVersion) + '/'
+                    + QByteArray::number(int(part->languageExtensions)) + '\n';
+            if (partsInUse) {
+                if (!m_headerPaths.contains(languageKey + includeKey))
+                    m_headerPaths.insert(languageKey + includeKey, part);
+                if (!m_projectDefines.contains(defines))
+                    m_projectDefines.insert(defines, part);
+                if (!m_toolchainDefines.contains(languageKey + flagsKey))
+                    m_toolchainDefines.insert(languageKey + flagsKey, part);
+                continue;
+            }
+
+            bool shared = false;
+            auto headerPathsIt = m_headerPaths.constFind(languageKey + includeKey);
+            if (headerPathsIt == m_headerPaths.constEnd()) {
+                m_headerPaths.insert(languageKey + includeKey, part);
+            } else {
+                m_savedBytes += headerPathsSize(part->headerPaths);
+                part->headerPaths = (*headerPathsIt)->headerPaths;
+                shared = true;
+            }
+
+            auto projectDefinesIt = m_projectDefines.constFind(defines);
+            if (projectDefinesIt == m_projectDefines.constEnd()) {
+                m_projectDefines.insert(defines, part);
+            } else if (part->projectDefines.constData()
+                       != (*projectDefinesIt)->projectDefines.constData()) {
+                m_savedBytes += part->projectDefines.size();
+                part->projectDefines = (*projectDefinesIt)->projectDefines;
+                shared = true;
+            }
+
+            auto toolchainDefinesIt = m_toolchainDefines.constFind(languageKey + flagsKey);
+            if (toolchainDefinesIt == m_toolchainDefines.constEnd()) {
+                m_toolchainDefines.insert(languageKey + flagsKey, part);
+            } else if (part->toolchainDefines.constData()
+                       != (*toolchainDefinesIt)->toolchainDefines.constData()) {
+                m_savedBytes += part->toolchainDefines.size();
+                part->toolchainDefines = (*toolchainDefinesIt)->toolchainDefines;
+                shared = true;
+            }
+
+            if (shared)
+                ++m_sharedParts;
+        }
+    }
+
+    int totalParts() const { return m_totalParts; }
+    int sharedParts() const { return m_sharedParts; }
+    qint64 savedBytes() const { return m_savedBytes; }
+
+private:
+    QHash<QByteArray, CppTools::ProjectPart::Ptr> m_headerPaths;
+    QHash<QByteArray, CppTools::ProjectPart::Ptr> m_projectDefines;
+    QHash<QByteArray, CppTools::ProjectPart::Ptr> m_toolchainDefines;
+    int m_totalParts = 0;
+    int m_sharedParts = 0;
+    qint64 m_savedBytes = 0;
+};
+
 } // ::anonymous
 
 void CMakeProject::parseCMakeOutput()
@@ -345,54 +374,321 @@ void CMakeProject::parseCMakeOutput()
 
     createGeneratedCodeModelSupport();
 
+    updateCppCodeModel(k, bdm);
+    updateQmlJSCodeModel();
+    updateCompletionIndex();
+
+    emit displayNameChanged();
+    emit fileListChanged();
+
+    emit cmakeBc->emitBuildTypeChanged();
+}
+
+namespace {
+
+enum CodeModelLanguage { CLanguage, CxxLanguage, ObjCLanguage, ObjCxxLanguage };
+
+const char *languageName(int language)
+{
+    switch (language) {
+    case CLanguage: return "C";
+    case CxxLanguage: return "C++";
+    case ObjCLanguage: return "Obj-C";
+    default: return "Obj-C++";
+    }
+}
+
+bool isCLanguage(int language)
+{
+    return language == CLanguage || language == ObjCLanguage;
+}
+
+QByteArray toolChainPartKey(int language, const QStringList &flags)
+{
+    return QByteArray::number(language) + '\n' + flags.join(QLatin1Char('\n')).toUtf8();
+}
+
+// One part per language, as ProjectPartBuilder does it
+QList<QPair<int, QList<CppTools::ProjectFile>>> languageFiles(const QStringList &files)
+{
+    using CppTools::ProjectFile;
+    QList<ProjectFile> byLanguage[ObjCxxLanguage + 1];
+    QList<ProjectFile> cHeaders;
+    foreach (const QString &file, files) {
+        const ProjectFile::Kind kind = ProjectFile::classify(file);
+        switch (kind) {
+        case ProjectFile::CHeader:
+            cHeaders << ProjectFile(file, kind);
+            break;
+        case ProjectFile::CSource:
+            byLanguage[CLanguage] << ProjectFile(file, kind);
+            break;
+        case ProjectFile::CXXHeader:
+        case ProjectFile::CXXSource:
+            byLanguage[CxxLanguage] << ProjectFile(file, kind);
+            break;
+        case ProjectFile::ObjCHeader:
+        case ProjectFile::ObjCSource:
+            byLanguage[ObjCLanguage] << ProjectFile(file, kind);
+            break;
+        case ProjectFile::ObjCXXHeader:
+        case ProjectFile::ObjCXXSource:
+            byLanguage[ObjCxxLanguage] << ProjectFile(file, kind);
+            break;
+        default:
+            break;
+        }
+    }
+    // Headers with an ambiguous extension are C++, unless the target is written in C
+    if (byLanguage[CxxLanguage].isEmpty() && !byLanguage[CLanguage].isEmpty())
+        byLanguage[CLanguage] += cHeaders;
+    else
+        byLanguage[CxxLanguage] += cHeaders;
+
+    QList<QPair<int, QList<ProjectFile>>> result;
+    for (int language = CLanguage; language <= ObjCxxLanguage; ++language) {
+        if (!byLanguage[language].isEmpty())
+            result << qMakePair(language, byLanguage[language]);
+    }
+    return result;
+}
+
+// Runs on the GUI thread: The toolchain may run the compiler and caches without locking
+CppTools::ProjectPart::Ptr toolChainPart(const ToolChain *tc, const Utils::FileName &sysRoot,
+                                         int language, const QStringList &flags)
+{
+    CppTools::ProjectPart::Ptr part(new CppTools::ProjectPart);
+    part->languageVersion = isCLanguage(language) ? CppTools::ProjectPart::C11
+                                                  : CppTools::ProjectPart::CXX11;
+    if (language == ObjCLanguage || language == ObjCxxLanguage)
+        part->languageExtensions |= CppTools::ProjectPart::ObjectiveCExtensions;
+    part->evaluateToolchain(tc, flags, sysRoot);
+    return part;
+}
+
+CppTools::ProjectPartHeaderPaths projectHeaderPaths(const QStringList &includePaths)
+{
+    CppTools::ProjectPartHeaderPaths headerPaths;
+    foreach (const QString &includePath, includePaths) {
+        // Frameworks on macOS are only reported as include paths ending in ".framework"
+        const int slash = includePath.lastIndexOf(QLatin1Char('/'));
+        if (includePath.endsWith(QLatin1String(".framework")) && slash != -1) {
+            headerPaths << CppTools::ProjectPartHeaderPath(includePath.left(slash),
+                                                           CppTools::ProjectPartHeaderPath::FrameworkPath);
+        } else {
+            headerPaths << CppTools::ProjectPartHeaderPath(includePath,
+                                                           CppTools::ProjectPartHeaderPath::IncludePath);
+        }
+    }
+    return headerPaths;
+}
+
+} // namespace
+
+void CMakeProject::updateCppCodeModel(Kit *k, BuildDirManager *bdm)
+{
+    // A new update supersedes any update that is still running. Canceling only asks the old
+    // workers to stop, so they may still run alongside the new ones: They share nothing but
+    // the flags cache, which locks, and the watchers drop their results.
+    m_codeModelTargetsWatcher.cancel();
+    m_codeModelUpdateWatcher.cancel();
+
     ToolChain *tc = ProjectExplorer::ToolChainKitInformation::toolChain(k);
     if (!tc) {
-        emit fileListChanged();
+        m_codeModelParts.clear();
         return;
     }
 
-    CppTools::CppModelManager *modelmanager = CppTools::CppModelManager::instance();
-    CppTools::ProjectInfo pinfo(this);
-    CppTools::ProjectPartBuilder ppBuilder(pinfo);
-
-    CppTools::ProjectPart::QtVersion activeQtVersion = CppTools::ProjectPart::NoQt;
+    CodeModelInput input;
+    input.projectInfo = CppTools::ProjectInfo(this);
+    input.project = this;
+    input.projectFile = projectFilePath().toString();
+    input.toolChainId = tc->id();
+    input.sysRoot = ProjectExplorer::SysRootKitInformation::sysRoot(k);
+    // The toolchain parts hold the macros and header paths of the compiler, which change with
+    // the compiler binary even if its toolchain stays the same
+    const Utils::FileName compiler = tc->compilerCommand();
+    input.toolChainFingerprint = compiler.toString().toUtf8() + '\n'
+            + QByteArray::number(compiler.toFileInfo().lastModified().toMSecsSinceEpoch());
     if (QtSupport::BaseQtVersion *qtVersion = QtSupport::QtKitInformation::qtVersion(k)) {
         if (qtVersion->qtVersion() < QtSupport::QtVersionNumber(5,0,0))
-            activeQtVersion = CppTools::ProjectPart::Qt4;
+            input.qtVersion = CppTools::ProjectPart::Qt4;
         else
-            activeQtVersion = CppTools::ProjectPart::Qt5;
+            input.qtVersion = CppTools::ProjectPart::Qt5;
     }
+    input.buildTargets = buildTargets();
+    input.projectDirectory = projectDirectory().toString();
+    input.buildDirectory = bdm->workDirectory().toString();
+    input.flagsCache = bdm->targetFlagsCache();
+    input.previousParts = m_codeModelParts;
+    input.previousProjectInfoValid
+            = CppTools::CppModelManager::instance()->projectInfo(this).isValid();
+
+    m_codeModelTargetsWatcher.setFuture(Utils::runAsync(&CMakeProject::resolveCodeModelTargets,
+                                                        input));
+}
 
-    ppBuilder.setQtVersion(activeQtVersion);
-
-    QHash<QString, QStringList> targetDataCache;
-    foreach (const CMakeBuildTarget &cbt, buildTargets()) {
+void CMakeProject::resolveCodeModelTargets(QFutureInterface<CodeModelInput> &futureInterface,
+                                           CodeModelInput input)
+{
+    // Runs in a worker thread, with nothing but the input
+    const QHash<QString, CMakeTargetFlags> targetFlags
+            = input.flagsCache->flags(input.buildTargets, input.projectDirectory,
+                                      input.buildDirectory);
+    foreach (const CMakeBuildTarget &cbt, input.buildTargets) {
+        if (futureInterface.isCanceled())
+            return;
+
+        const CMakeTargetFlags flags = targetFlags.value(cbt.title);
+
+        CodeModelTarget target;
+        target.title = cbt.title;
         // This explicitly adds -I. to the include paths
-        QStringList includePaths = cbt.includeFiles;
-        includePaths += projectDirectory().toString();
-    //allIncludePaths.append(paths); // This want a lot of memory
-        ppBuilder.setIncludePaths(includePaths);
-        QStringList cxxflags = getCXXFlagsFor(cbt, targetDataCache);
-        ppBuilder.setCFlags(cxxflags);
-        ppBuilder.setCxxFlags(cxxflags);
-        ppBuilder.setDefines(cbt.defines);
-        ppBuilder.setDisplayName(cbt.title);
-
-        const QList<Core::Id> languages = ppBuilder.createProjectPartsForFiles(cbt.files);
-        foreach (Core::Id language, languages)
-            setProjectLanguage(language, true);
+        target.includePaths = cbt.includeFiles.isEmpty() ? flags.includePaths : cbt.includeFiles;
+        target.includePaths += input.projectDirectory;
+        target.cFlags = flags.cFlags.isEmpty() ? flags.cxxFlags : flags.cFlags;
+        target.cxxFlags = flags.cxxFlags.isEmpty() ? flags.cFlags : flags.cxxFlags;
+        target.defines = cbt.defines.isEmpty() ? flags.defines : cbt.defines;
+
+        QCryptographicHash inputHash(QCryptographicHash::Sha1);
+        inputHash.addData(input.toolChainId);
+        inputHash.addData(input.toolChainFingerprint);
+        inputHash.addData(input.sysRoot.toString().toUtf8());
+        inputHash.addData(QByteArray::number(int(input.qtVersion)));
+        for (const QStringList &list : { cbt.files, target.includePaths, target.cFlags, target.cxxFlags }) {
+            inputHash.addData(list.join(QLatin1Char('\n')).toUtf8());
+            inputHash.addData("\0", 1);
+        }
+        inputHash.addData(target.defines);
+        target.inputHash = inputHash.result();
+
+        target.reuseParts = input.previousParts.value(cbt.title).inputHash == target.inputHash;
+        if (!target.reuseParts)
+            target.languageFiles = languageFiles(cbt.files);
+        input.targets.append(target);
     }
+    futureInterface.reportResult(input);
+}
 
-    m_codeModelFuture.cancel();
-    pinfo.finish();
-    m_codeModelFuture = modelmanager->updateProjectInfo(pinfo);
+void CMakeProject::handleCodeModelTargets()
+{
+    if (m_codeModelTargetsWatcher.isCanceled()
+            || m_codeModelTargetsWatcher.future().resultCount() == 0) {
+        return;
+    }
+    CodeModelInput input = m_codeModelTargetsWatcher.result();
+
+    Kit *k = activeTarget() ? activeTarget()->kit() : nullptr;
+    const ToolChain *tc = ProjectExplorer::ToolChainKitInformation::toolChain(k);
+    if (!tc || tc->id() != input.toolChainId)
+        return; // The kit changed, which starts another update
+
+    // Only the changed targets need the toolchain, and most of them share their flags
+    foreach (const CodeModelTarget &target, input.targets) {
+        for (const QPair<int, QList<CppTools::ProjectFile>> &files : target.languageFiles) {
+            const QStringList &flags = isCLanguage(files.first) ? target.cFlags : target.cxxFlags;
+            const QByteArray key = toolChainPartKey(files.first, flags);
+            if (!input.toolChainParts.contains(key))
+                input.toolChainParts.insert(key, toolChainPart(tc, input.sysRoot, files.first, flags));
+        }
+    }
 
-    updateQmlJSCodeModel();
+    m_codeModelUpdateWatcher.setFuture(Utils::runAsync(&CMakeProject::buildCppCodeModel, input));
+}
 
-    emit displayNameChanged();
-    emit fileListChanged();
+void CMakeProject::buildCppCodeModel(QFutureInterface<CodeModelUpdate> &futureInterface,
+                                     const CodeModelInput &input)
+{
+    // Runs in a worker thread: Everything needed is in the input, which includes what the
+    // toolchain said. Neither the project nor the toolchain are looked at.
+    CodeModelUpdate update;
+    update.projectInfo = input.projectInfo;
+
+    ProjectPartInterner interner;
+    int reusedTargets = 0;
+    foreach (const CodeModelTarget &target, input.targets) {
+        if (futureInterface.isCanceled())
+            return;
+
+        CodeModelTargetParts targetParts = input.previousParts.value(target.title);
+        if (target.reuseParts) {
+            // Nothing changed for this target: Keep its parts, so that the code model sees
+            // the very same objects as before.
+            foreach (const CppTools::ProjectPart::Ptr &part, targetParts.parts)
+                update.projectInfo.appendProjectPart(part);
+            ++reusedTargets;
+        } else {
+            targetParts.inputHash = target.inputHash;
+            targetParts.parts.clear();
+            targetParts.languages.clear();
+            const CppTools::ProjectPartHeaderPaths includePaths = projectHeaderPaths(target.includePaths);
+            for (const QPair<int, QList<CppTools::ProjectFile>> &files : target.languageFiles) {
+                const QStringList &flags = isCLanguage(files.first) ? target.cFlags : target.cxxFlags;
+                const CppTools::ProjectPart::Ptr toolChainPart
+                        = input.toolChainParts.value(toolChainPartKey(files.first, flags));
+                QTC_ASSERT(toolChainPart, continue);
+
+                CppTools::ProjectPart::Ptr part = toolChainPart->copy();
+                part->project = input.project;
+                part->projectFile = input.projectFile;
+                part->displayName = target.languageFiles.count() > 1
+                        ? target.title + QLatin1String(" (") + QLatin1String(languageName(files.first))
+                          + QLatin1Char(')')
+                        : target.title;
+                part->files = files.second;
+                part->qtVersion = input.qtVersion;
+                part->projectDefines = target.defines;
+                part->headerPaths = includePaths;
+                foreach (const CppTools::ProjectPartHeaderPath &headerPath, toolChainPart->headerPaths) {
+                    if (!part->headerPaths.contains(headerPath))
+                        part->headerPaths << headerPath;
+                }
+                part->updateLanguageFeatures();
 
-    emit cmakeBc->emitBuildTypeChanged();
+                update.projectInfo.appendProjectPart(part);
+                targetParts.parts << part;
+            }
+            if (!targetParts.parts.isEmpty())
+                targetParts.languages << ProjectExplorer::Constants::LANG_CXX;
+        }
+
+        interner.intern(targetParts.parts, target.reuseParts, target.includePaths, target.defines,
+                        target.cFlags, target.cxxFlags);
+        update.targetParts.insert(target.title, targetParts);
+    }
+
+    QLoggingCategory log("qtc.cmakeprojectmanager.codemodel");
+    qCDebug(log) << interner.sharedParts() << "of" << interner.totalParts()
+                 << "project parts share code model data, saving about"
+                 << interner.savedBytes() / 1024 << "KiB";
+    qCDebug(log) << "Reused the project parts of" << reusedTargets << "of"
+                 << input.targets.count() << "targets";
+
+    update.projectInfoChanged = reusedTargets != input.targets.count()
+            || update.targetParts.count() != input.previousParts.count()
+            || !input.previousProjectInfoValid;
+    if (update.projectInfoChanged)
+        update.projectInfo.finish();
+
+    futureInterface.reportResult(update);
+}
+
+void CMakeProject::handleCppCodeModelUpdate()
+{
+    if (m_codeModelUpdateWatcher.isCanceled() || m_codeModelUpdateWatcher.future().resultCount() == 0)
+        return;
+
+    const CodeModelUpdate update = m_codeModelUpdateWatcher.result();
+    m_codeModelParts = update.targetParts;
+    foreach (const CodeModelTargetParts &targetParts, update.targetParts) {
+        foreach (Core::Id language, targetParts.languages)
+            setProjectLanguage(language, true);
+    }
+
+    if (update.projectInfoChanged) {
+        m_codeModelFuture.cancel();
+        m_codeModelFuture = CppTools::CppModelManager::instance()->updateProjectInfo(update.projectInfo);
+    }
 }
 
 void CMakeProject::updateQmlJSCodeModel()
@@ -428,6 +724,40 @@ void CMakeProject::updateQmlJSCodeModel()
     modelManager->updateProjectInfo(projectInfo, this);
 }
 
+QSharedPointer<const CMakeCompletionIndex> CMakeProject::completionIndex() const
+{
+    QMutexLocker locker(&m_completionIndexMutex);
+    return m_completionIndex;
+}
+
+TextEditor::Keywords CMakeProject::cmakeKeywords() const
+{
+    CMakeTool *cmake = activeTarget() ? CMakeKitInformation::cmakeTool(activeTarget()->kit()) : nullptr;
+    return cmake && !cmake->isValidationPending() ? cmake->keywords() : TextEditor::Keywords();
+}
+
+// Before the project is parsed, or when parsing fails, the index has the keywords of cmake only
+void CMakeProject::updateCompletionIndex()
+{
+    auto bc = activeTarget()
+            ? qobject_cast<CMakeBuildConfiguration *>(activeTarget()->activeBuildConfiguration())
+            : nullptr;
+    BuildDirManager *bdm = bc ? bc->buildDirManager() : nullptr;
+
+    const TextEditor::Keywords keywords = cmakeKeywords();
+    const CMakeConfig configuration = bdm ? bdm->parsedConfiguration() : CMakeConfig();
+    const QList<Utils::FileName> cmakeFiles = bdm ? bdm->cmakeFiles() : QList<Utils::FileName>();
+    m_completionIndexWatcher.setFuture(Utils::runAsync([keywords, configuration, cmakeFiles]() {
+        auto index = new CMakeCompletionIndex;
+        index->addKeywords(keywords);
+        index->addCacheEntries(configuration);
+        foreach (const Utils::FileName &cmakeFile, cmakeFiles)
+            index->addCMakeFile(cmakeFile);
+        index->finish();
+        return QSharedPointer<const CMakeCompletionIndex>(index);
+    }));
+}
+
 bool CMakeProject::needsConfiguration() const
 {
     return targets().isEmpty();
@@ -639,6 +969,13 @@ void CMakeProject::handleActiveTargetChanged()
 
 void CMakeProject::handleActiveBuildConfigurationChanged()
 {
+    // The running code model update was started for the previous configuration
+    m_codeModelTargetsWatcher.cancel();
+    m_codeModelUpdateWatcher.cancel();
+
+    // The kit may come with other cmake keywords, which are there before the parse is done
+    updateCompletionIndex();
+
     if (!activeTarget() || !activeTarget()->activeBuildConfiguration())
         return;
     auto activeBc = qobject_cast<CMakeBuildConfiguration *>(activeTarget()->activeBuildConfiguration());
@@ -675,17 +1012,7 @@ QStringList CMakeProject::filesGeneratedFrom(const QString &sourceFile) const
         return QStringList();
     QFileInfo fi(sourceFile);
     FileName project = projectDirectory();
-    FileName baseDirectory = FileName::fromString(fi.absolutePath());
-
-    while (baseDirectory.isChildOf(project)) {
-        FileName cmakeListsTxt = baseDirectory;
-        cmakeListsTxt.appendPath(QLatin1String("CMakeLists.txt"));
-        if (cmakeListsTxt.exists())
-            break;
-        QDir dir(baseDirectory.toString());
-        dir.cdUp();
-        baseDirectory = FileName::fromString(dir.absolutePath());
-    }
+    FileName baseDirectory = cmakeListsDirectory(FileName::fromString(fi.absolutePath()));
 
     QDir srcDirRoot = QDir(project.toString());
     QString relativePath = srcDirRoot.relativeFilePath(baseDirectory.toString());
@@ -708,6 +1035,34 @@ QStringList CMakeProject::filesGeneratedFrom(const QString &sourceFile) const
     }
 }
 
+FileName CMakeProject::cmakeListsDirectory(const FileName &directory) const
+{
+    const FileName project = projectDirectory();
+    FileNameList visited;
+    FileName baseDirectory = directory;
+
+    while (baseDirectory.isChildOf(project)) {
+        auto it = m_cmakeListsDirectories.constFind(baseDirectory);
+        if (it != m_cmakeListsDirectories.constEnd()) {
+            baseDirectory = it.value();
+            break;
+        }
+        visited.append(baseDirectory);
+        FileName cmakeListsTxt = baseDirectory;
+        cmakeListsTxt.appendPath(QLatin1String("CMakeLists.txt"));
+        if (cmakeListsTxt.exists())
+            break;
+        QDir dir(baseDirectory.toString());
+        dir.cdUp();
+        baseDirectory = FileName::fromString(dir.absolutePath());
+    }
+
+    // All directories on the way share the result
+    foreach (const FileName &visitedDirectory, visited)
+        m_cmakeListsDirectories.insert(visitedDirectory, baseDirectory);
+    return baseDirectory;
+}
+
 void CMakeProject::updateTargetRunConfigurations(Target *t)
 {
     // *Update* existing runconfigurations (no need to update new ones!):
@@ -797,28 +1152,65 @@ void CMakeProject::updateApplicationAndDeploymentTargets()
 
 void CMakeProject::createGeneratedCodeModelSupport()
 {
-    qDeleteAll(m_extraCompilers);
-    m_extraCompilers.clear();
-    QList<ProjectExplorer::ExtraCompilerFactory *> factories =
-            ProjectExplorer::ExtraCompilerFactory::extraCompilerFactories();
+    // CMakeLists.txt files might have been added or removed since the last parse
+    m_cmakeListsDirectories.clear();
+
+    QHash<QString, QList<ProjectExplorer::ExtraCompilerFactory *> > factoriesBySuffix;
+    foreach (ProjectExplorer::ExtraCompilerFactory *factory,
+             ProjectExplorer::ExtraCompilerFactory::extraCompilerFactories()) {
+        factoriesBySuffix[factory->sourceTag()].append(factory);
+    }
+
+    auto compilerKey = [](ProjectExplorer::ExtraCompilerFactory *factory, const FileName &source,
+                          const FileNameList &targets) {
+        QString key = QString::number(quintptr(factory)) + QLatin1Char('\n') + source.toString();
+        foreach (const FileName &target, targets)
+            key += QLatin1Char('\n') + target.toString();
+        return key;
+    };
+
+    // Extra compilers for a source that still generates the same files are kept
+    QHash<QString, ProjectExplorer::ExtraCompiler *> oldCompilers;
+    foreach (ProjectExplorer::ExtraCompiler *compiler, m_extraCompilers) {
+        oldCompilers.insert(compilerKey(m_extraCompilerFactories.value(compiler),
+                                        compiler->source(), compiler->targets()),
+                            compiler);
+    }
+
+    QList<ProjectExplorer::ExtraCompiler *> extraCompilers;
+    QHash<ProjectExplorer::ExtraCompiler *, ProjectExplorer::ExtraCompilerFactory *> extraCompilerFactories;
 
     // Find all files generated by any of the extra compilers, in a rather crude way.
     foreach (const QString &file, files(SourceFiles)) {
-        foreach (ProjectExplorer::ExtraCompilerFactory *factory, factories) {
-            if (file.endsWith(QLatin1Char('.') + factory->sourceTag())) {
-                QStringList generated = filesGeneratedFrom(file);
-                if (!generated.isEmpty()) {
-                    const FileNameList fileNames = Utils::transform(generated,
-                                                                    [](const QString &s) {
-                        return FileName::fromString(s);
-                    });
-                    m_extraCompilers.append(factory->create(this, FileName::fromString(file),
-                                                            fileNames));
-                }
-            }
+        const int dot = file.lastIndexOf(QLatin1Char('.'));
+        if (dot == -1)
+            continue;
+        auto factories = factoriesBySuffix.constFind(file.mid(dot + 1));
+        if (factories == factoriesBySuffix.constEnd())
+            continue;
+
+        const QStringList generated = filesGeneratedFrom(file);
+        if (generated.isEmpty())
+            continue;
+        const FileName source = FileName::fromString(file);
+        const FileNameList fileNames = Utils::transform(generated, [](const QString &s) {
+            return FileName::fromString(s);
+        });
+
+        foreach (ProjectExplorer::ExtraCompilerFactory *factory, factories.value()) {
+            ProjectExplorer::ExtraCompiler *compiler
+                    = oldCompilers.take(compilerKey(factory, source, fileNames));
+            if (!compiler)
+                compiler = factory->create(this, source, fileNames);
+            extraCompilers.append(compiler);
+            extraCompilerFactories.insert(compiler, factory);
         }
     }
 
+    qDeleteAll(oldCompilers);
+    m_extraCompilers = extraCompilers;
+    m_extraCompilerFactories = extraCompilerFactories;
+
     CppTools::GeneratedCodeModelSupport::update(m_extraCompilers);
 }
 
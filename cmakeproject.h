@@ -38,10 +38,20 @@
 #include <coreplugin/editormanager/editormanager.h>
 #include <coreplugin/editormanager/ieditor.h>
 
+#include <cpptools/projectfile.h>
+#include <cpptools/projectinfo.h>
+#include <cpptools/projectpart.h>
+
+#include <texteditor/codeassist/keywordscompletionassist.h>
+
 #include <utils/fileutils.h>
 #include <utils/qtcprocess.h>
 
 #include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QPair>
+#include <QSharedPointer>
 #include <QXmlStreamReader>
 #include <QPushButton>
 #include <QLineEdit>
@@ -54,12 +64,14 @@ namespace CMakeProjectManager {
 
 namespace Internal {
 class BuildDirManager;
+class CMakeCompletionIndex;
 class CMakeFile;
 class CMakeBuildSettingsWidget;
 class CMakeProjectNode;
 class CMakeBuildConfiguration;
 class CMakeProjectNode;
 class CMakeManager;
+class CMakeTargetFlagsCache;
 } // namespace Internal
 
 enum TargetType {
@@ -119,6 +131,10 @@ public:
 
     void runCMake();
 
+    // For the completion in CMake files, with the keywords of cmake until the project is parsed.
+    // Thread-safe, as the completion asks from a worker thread.
+    QSharedPointer<const Internal::CMakeCompletionIndex> completionIndex() const;
+
 signals:
     /// emitted when cmake is running:
     void parsingStarted();
@@ -132,25 +148,100 @@ private:
     void handleActiveBuildConfigurationChanged();
     void handleParsingStarted();
     void parseCMakeOutput();
+    void updateCppCodeModel(ProjectExplorer::Kit *k, Internal::BuildDirManager *bdm);
+    void handleCppCodeModelUpdate();
     void updateQmlJSCodeModel();
+    void updateCompletionIndex();
+    TextEditor::Keywords cmakeKeywords() const;
 
     void buildTree(Internal::CMakeProjectNode *rootNode, QList<ProjectExplorer::FileNode *> list);
     void gatherFileNodes(ProjectExplorer::FolderNode *parent, QList<ProjectExplorer::FileNode *> &list) const;
     ProjectExplorer::FolderNode *findOrCreateFolder(Internal::CMakeProjectNode *rootNode, QString directory);
     void createGeneratedCodeModelSupport();
     QStringList filesGeneratedFrom(const QString &sourceFile) const override;
+    Utils::FileName cmakeListsDirectory(const Utils::FileName &directory) const;
     void updateTargetRunConfigurations(ProjectExplorer::Target *t);
     void updateApplicationAndDeploymentTargets();
-    QStringList getCXXFlagsFor(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache);
-    bool extractCXXFlagsFromMake(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache);
-    bool extractCXXFlagsFromNinja(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache);
 
     ProjectExplorer::Target *m_connectedTarget = nullptr;
 
+    // The code model input of a target and the project parts that were created from it
+    class CodeModelTargetParts
+    {
+    public:
+        QByteArray inputHash;
+        QList<CppTools::ProjectPart::Ptr> parts;
+        QList<Core::Id> languages;
+    };
+
+    // What a target is built from, resolved from its flags in a worker thread
+    class CodeModelTarget
+    {
+    public:
+        QString title;
+        QStringList includePaths;
+        QStringList cFlags;
+        QStringList cxxFlags;
+        QByteArray defines;
+        QByteArray inputHash;
+        bool reuseParts = false;
+        QList<QPair<int, QList<CppTools::ProjectFile>>> languageFiles; // one part per language
+    };
+
+    // Snapshot of the project state, taken on the GUI thread. The targets are resolved in a
+    // worker thread, the toolchain is asked about their flags on the GUI thread, and the project
+    // parts are built in a worker thread again. Workers neither look at the project nor at the
+    // toolchain.
+    class CodeModelInput
+    {
+    public:
+        CppTools::ProjectInfo projectInfo; // Empty, only refers to the project
+        ProjectExplorer::Project *project = nullptr; // Never dereferenced by workers
+        QString projectFile;
+        QByteArray toolChainId;
+        QByteArray toolChainFingerprint; // compiler path and modification time
+        Utils::FileName sysRoot;
+        CppTools::ProjectPart::QtVersion qtVersion = CppTools::ProjectPart::NoQt;
+        QList<CMakeBuildTarget> buildTargets;
+        QString projectDirectory;
+        QString buildDirectory;
+        QSharedPointer<Internal::CMakeTargetFlagsCache> flagsCache;
+        QHash<QString, CodeModelTargetParts> previousParts;
+        bool previousProjectInfoValid = false;
+
+        QList<CodeModelTarget> targets;
+        // Language and flags -> part holding what the toolchain says about them
+        QHash<QByteArray, CppTools::ProjectPart::Ptr> toolChainParts;
+    };
+
+    // Computed in a worker thread from a CodeModelInput
+    class CodeModelUpdate
+    {
+    public:
+        CppTools::ProjectInfo projectInfo;
+        QHash<QString, CodeModelTargetParts> targetParts;
+        bool projectInfoChanged = true;
+    };
+
+    static void resolveCodeModelTargets(QFutureInterface<CodeModelInput> &futureInterface,
+                                        CodeModelInput input);
+    void handleCodeModelTargets();
+    static void buildCppCodeModel(QFutureInterface<CodeModelUpdate> &futureInterface,
+                                  const CodeModelInput &input);
+
     // TODO probably need a CMake specific node structure
     QList<CMakeBuildTarget> m_buildTargets;
     QFuture<void> m_codeModelFuture;
+    QFutureWatcher<CodeModelInput> m_codeModelTargetsWatcher;
+    QFutureWatcher<CodeModelUpdate> m_codeModelUpdateWatcher;
+    QHash<QString, CodeModelTargetParts> m_codeModelParts;
+    QFutureWatcher<QSharedPointer<const Internal::CMakeCompletionIndex>> m_completionIndexWatcher;
+    QSharedPointer<const Internal::CMakeCompletionIndex> m_completionIndex;
+    mutable QMutex m_completionIndexMutex; // guards m_completionIndex
     QList<ProjectExplorer::ExtraCompiler *> m_extraCompilers;
+    QHash<ProjectExplorer::ExtraCompiler *, ProjectExplorer::ExtraCompilerFactory *> m_extraCompilerFactories;
+    // directory -> closest directory with a CMakeLists.txt, reset on every parse
+    mutable QHash<Utils::FileName, Utils::FileName> m_cmakeListsDirectories;
 
     friend class Internal::CMakeBuildConfiguration;
 };
@@ -36,6 +36,10 @@ const char CMAKE_EDITOR_DISPLAY_NAME[] = "CMake Editor";
 const char RUNCMAKE[] = "CMakeProject.RunCMake";
 const char CLEARCMAKECACHE[] = "CMakeProject.ClearCache";
 const char RUNCMAKECONTEXTMENU[] = "CMakeProject.RunCMakeContextMenu";
+const char SHOWBUILDREPORT[] = "CMakeProject.ShowBuildReport";
+const char COMPILECURRENTFILE[] = "CMakeProject.CompileCurrentFile";
+const char COMPILEFILECONTEXTMENU[] = "CMakeProject.CompileFileContextMenu";
+const char BUILDAFFECTEDTARGETS[] = "CMakeProject.BuildAffectedTargets";
 
 // Project
 const char CMAKEPROJECT_ID[] = "CMakeProjectManager.CMakeProject";
@@ -26,6 +26,9 @@
 #include "cmakeprojectmanager.h"
 #include "builddirmanager.h"
 #include "cmakebuildconfiguration.h"
+#include "cmakebuildreport.h"
+#include "cmakebuildreportdialog.h"
+#include "cmakebuildstep.h"
 #include "cmakekitinformation.h"
 #include "cmakeprojectconstants.h"
 #include "cmakeproject.h"
@@ -36,18 +39,27 @@
 #include <coreplugin/actionmanager/actionmanager.h>
 #include <coreplugin/actionmanager/command.h>
 #include <coreplugin/actionmanager/actioncontainer.h>
+#include <coreplugin/documentmanager.h>
+#include <coreplugin/editormanager/editormanager.h>
+#include <coreplugin/idocument.h>
+#include <coreplugin/messagemanager.h>
 #include <projectexplorer/buildmanager.h>
+#include <projectexplorer/buildsteplist.h>
 #include <projectexplorer/projectexplorer.h>
 #include <projectexplorer/projectexplorerconstants.h>
+#include <projectexplorer/projectnodes.h>
 #include <projectexplorer/projecttree.h>
 #include <projectexplorer/session.h>
 #include <projectexplorer/target.h>
 
+#include <utils/algorithm.h>
+#include <utils/hostosinfo.h>
 #include <utils/qtcprocess.h>
 #include <utils/synchronousprocess.h>
 
 #include <QAction>
 #include <QDateTime>
+#include <QDir>
 #include <QIcon>
 
 using namespace ProjectExplorer;
@@ -56,7 +68,11 @@ using namespace CMakeProjectManager::Internal;
 CMakeManager::CMakeManager() :
     m_runCMakeAction(new QAction(QIcon(), tr("Run CMake"), this)),
     m_clearCMakeCacheAction(new QAction(QIcon(), tr("Clear CMake Configuration"), this)),
-    m_runCMakeActionContextMenu(new QAction(QIcon(), tr("Run CMake"), this))
+    m_runCMakeActionContextMenu(new QAction(QIcon(), tr("Run CMake"), this)),
+    m_showBuildReportAction(new QAction(QIcon(), tr("Show Build Report"), this)),
+    m_compileCurrentFileAction(new QAction(QIcon(), tr("Compile Current File"), this)),
+    m_compileFileActionContextMenu(new QAction(QIcon(), tr("Compile"), this)),
+    m_buildAffectedTargetsAction(new QAction(QIcon(), tr("Build Affected Targets"), this))
 {
     Core::ActionContainer *mbuild =
             Core::ActionManager::actionContainer(ProjectExplorer::Constants::M_BUILDPROJECT);
@@ -64,6 +80,8 @@ CMakeManager::CMakeManager() :
             Core::ActionManager::actionContainer(ProjectExplorer::Constants::M_PROJECTCONTEXT);
     Core::ActionContainer *msubproject =
             Core::ActionManager::actionContainer(ProjectExplorer::Constants::M_SUBPROJECTCONTEXT);
+    Core::ActionContainer *mfile =
+            Core::ActionManager::actionContainer(ProjectExplorer::Constants::M_FILECONTEXT);
 
     const Core::Context projectContext(CMakeProjectManager::Constants::PROJECTCONTEXT);
     const Core::Context globalContext(Core::Constants::C_GLOBAL);
@@ -84,6 +102,41 @@ CMakeManager::CMakeManager() :
         clearCMakeCache(SessionManager::startupProject());
     });
 
+    command = Core::ActionManager::registerAction(m_showBuildReportAction,
+                                                  Constants::SHOWBUILDREPORT, globalContext);
+    command->setAttribute(Core::Command::CA_Hide);
+    mbuild->addAction(command, ProjectExplorer::Constants::G_BUILD_DEPLOY);
+    connect(m_showBuildReportAction, &QAction::triggered, [this]() {
+        showBuildReport(SessionManager::startupProject());
+    });
+
+    command = Core::ActionManager::registerAction(m_compileCurrentFileAction,
+                                                  Constants::COMPILECURRENTFILE, globalContext);
+    command->setAttribute(Core::Command::CA_Hide);
+    command->setAttribute(Core::Command::CA_UpdateText);
+    mbuild->addAction(command, ProjectExplorer::Constants::G_BUILD_BUILD);
+    connect(m_compileCurrentFileAction, &QAction::triggered, [this]() {
+        if (Core::IDocument *document = Core::EditorManager::currentDocument())
+            compileFile(SessionManager::projectForFile(document->filePath()), document->filePath());
+    });
+
+    command = Core::ActionManager::registerAction(m_buildAffectedTargetsAction,
+                                                  Constants::BUILDAFFECTEDTARGETS, globalContext);
+    command->setAttribute(Core::Command::CA_Hide);
+    mbuild->addAction(command, ProjectExplorer::Constants::G_BUILD_BUILD);
+    connect(m_buildAffectedTargetsAction, &QAction::triggered, [this]() {
+        buildAffectedTargets(SessionManager::startupProject());
+    });
+
+    command = Core::ActionManager::registerAction(m_compileFileActionContextMenu,
+                                                  Constants::COMPILEFILECONTEXTMENU, projectContext);
+    command->setAttribute(Core::Command::CA_Hide);
+    mfile->addAction(command, ProjectExplorer::Constants::G_FILE_OTHER);
+    connect(m_compileFileActionContextMenu, &QAction::triggered, [this]() {
+        if (Node *node = ProjectTree::currentNode())
+            compileFile(ProjectTree::currentProject(), node->filePath());
+    });
+
     command = Core::ActionManager::registerAction(m_runCMakeActionContextMenu,
                                                   Constants::RUNCMAKECONTEXTMENU, projectContext);
     command->setAttribute(Core::Command::CA_Hide);
@@ -97,6 +150,8 @@ CMakeManager::CMakeManager() :
             this, &CMakeManager::updateCmakeActions);
     connect(BuildManager::instance(), &BuildManager::buildStateChanged,
             this, &CMakeManager::updateCmakeActions);
+    connect(Core::EditorManager::instance(), &Core::EditorManager::currentEditorChanged,
+            this, &CMakeManager::updateCmakeActions);
 
     updateCmakeActions();
 }
@@ -107,6 +162,16 @@ void CMakeManager::updateCmakeActions()
     const bool visible = project && !BuildManager::isBuilding(project);
     m_runCMakeAction->setVisible(visible);
     m_clearCMakeCacheAction->setVisible(visible);
+    m_showBuildReportAction->setVisible(visible);
+    m_buildAffectedTargetsAction->setVisible(visible);
+
+    Core::IDocument *document = Core::EditorManager::currentDocument();
+    const bool canCompile = document
+            && qobject_cast<CMakeProject *>(SessionManager::projectForFile(document->filePath()))
+            && !BuildManager::isBuilding();
+    m_compileCurrentFileAction->setVisible(canCompile);
+    if (canCompile)
+        m_compileCurrentFileAction->setText(tr("Compile \"%1\"").arg(document->filePath().fileName()));
 }
 
 void CMakeManager::clearCMakeCache(Project *project)
@@ -134,6 +199,129 @@ void CMakeManager::runCMake(Project *project)
     cmakeProject->runCMake();
 }
 
+void CMakeManager::showBuildReport(Project *project)
+{
+    if (!project || !project->activeTarget())
+        return;
+    auto bc = qobject_cast<CMakeBuildConfiguration *>(project->activeTarget()->activeBuildConfiguration());
+    if (!bc)
+        return;
+
+    CMakeBuildReportDialog dialog(bc->buildDirManager()->buildReport(), Core::ICore::dialogParent());
+    dialog.exec();
+}
+
+QString CMakeManager::objectFile(const CMakeBuildTarget &target, const Utils::FileName &sourceFile,
+                                 const Utils::FileName &sourceDirectory,
+                                 const Utils::FileName &buildDirectory)
+{
+    // CMake places the objects of a target in the binary directory of the CMakeLists.txt that
+    // defined it, named after the source path relative to that directory, with ".." as "__"
+    const QString targetSourceDirectory = target.sourceDirectory.isEmpty()
+            ? sourceDirectory.toString() : target.sourceDirectory;
+    QString binaryDirectory = QDir(sourceDirectory.toString()).relativeFilePath(targetSourceDirectory);
+    if (binaryDirectory.startsWith(QLatin1String("..")))
+        binaryDirectory = QDir(buildDirectory.toString()).relativeFilePath(target.workingDirectory);
+    if (binaryDirectory == QLatin1String("."))
+        binaryDirectory.clear();
+    else if (!binaryDirectory.isEmpty())
+        binaryDirectory += QLatin1Char('/');
+
+    const QString absoluteBinaryDirectory = QDir::cleanPath(buildDirectory.toString() + QLatin1Char('/')
+                                                            + binaryDirectory);
+    QString source = sourceFile.isChildOf(Utils::FileName::fromString(absoluteBinaryDirectory))
+            ? QDir(absoluteBinaryDirectory).relativeFilePath(sourceFile.toString())
+            : QDir(targetSourceDirectory).relativeFilePath(sourceFile.toString());
+    source.replace(QLatin1String("../"), QLatin1String("__/"));
+
+    const QLatin1String extension = Utils::HostOsInfo::isWindowsHost()
+            ? QLatin1String(".obj") : QLatin1String(".o");
+    return binaryDirectory + QLatin1String("CMakeFiles/") + target.title + QLatin1String(".dir/")
+            + source + extension;
+}
+
+void CMakeManager::compileFile(Project *project, const Utils::FileName &sourceFile)
+{
+    auto cmakeProject = qobject_cast<CMakeProject *>(project);
+    if (!cmakeProject || !cmakeProject->activeTarget())
+        return;
+    auto bc = qobject_cast<CMakeBuildConfiguration *>(cmakeProject->activeTarget()->activeBuildConfiguration());
+    if (!bc)
+        return;
+    auto buildStep = bc->stepList(ProjectExplorer::Constants::BUILDSTEPS_BUILD)->firstOfType<CMakeBuildStep>();
+    if (!buildStep)
+        return;
+
+    const QString fileName = sourceFile.toString();
+    const QList<CMakeBuildTarget> targets = cmakeProject->buildTargets();
+    const auto target = std::find_if(targets.constBegin(), targets.constEnd(),
+                                     [&fileName](const CMakeBuildTarget &target) {
+        return target.targetType != UtilityType && target.files.contains(fileName);
+    });
+    if (target == targets.constEnd()) {
+        Core::MessageManager::write(tr("\"%1\" is not compiled as part of a CMake target.")
+                                    .arg(sourceFile.toUserOutput()));
+        return;
+    }
+
+    const QString object = objectFile(*target, sourceFile, cmakeProject->projectDirectory(),
+                                      bc->buildDirectory());
+
+    // Ninja knows the object file as an output of the build graph. With Makefiles it is
+    // a rule of the build.make of the target, which is run directly from the build directory.
+    const QStringList oldTargets = buildStep->buildTargets();
+    const QString oldArguments = buildStep->toolArguments();
+    if (Utils::FileName(bc->buildDirectory()).appendPath(QLatin1String("build.ninja")).exists()) {
+        buildStep->setBuildTarget(object);
+    } else {
+        QString arguments;
+        Utils::QtcProcess::addArg(&arguments, QLatin1String("-f"));
+        Utils::QtcProcess::addArg(&arguments, object.left(object.indexOf(QLatin1String(".dir/")) + 5)
+                                  + QLatin1String("build.make"));
+        Utils::QtcProcess::addArg(&arguments, object);
+        if (!oldArguments.isEmpty())
+            arguments += QLatin1Char(' ') + oldArguments;
+        buildStep->clearBuildTargets();
+        buildStep->setToolArguments(arguments);
+    }
+
+    ProjectExplorerPlugin::buildProject(cmakeProject);
+    buildStep->setBuildTargets(oldTargets);
+    buildStep->setToolArguments(oldArguments);
+}
+
+void CMakeManager::buildAffectedTargets(Project *project)
+{
+    auto cmakeProject = qobject_cast<CMakeProject *>(project);
+    if (!cmakeProject || !cmakeProject->activeTarget())
+        return;
+    auto bc = qobject_cast<CMakeBuildConfiguration *>(cmakeProject->activeTarget()->activeBuildConfiguration());
+    if (!bc)
+        return;
+    auto buildStep = bc->stepList(ProjectExplorer::Constants::BUILDSTEPS_BUILD)->firstOfType<CMakeBuildStep>();
+    if (!buildStep)
+        return;
+
+    // Modified editors count even when they are not saved now, as the build saves them anyway
+    const QStringList modifiedFiles = Utils::transform(Core::DocumentManager::modifiedDocuments(),
+                                                       [](Core::IDocument *document) {
+        return document->filePath().toString();
+    });
+    if (!ProjectExplorerPlugin::saveModifiedFiles())
+        return;
+
+    const QStringList targets = bc->buildDirManager()->affectedTargets(modifiedFiles);
+    if (targets.isEmpty()) {
+        Core::MessageManager::write(tr("No CMake target is affected by the modified files."));
+        return;
+    }
+
+    const QStringList oldTargets = buildStep->buildTargets();
+    buildStep->setBuildTargets(targets);
+    ProjectExplorerPlugin::buildProject(cmakeProject);
+    buildStep->setBuildTargets(oldTargets);
+}
+
 Project *CMakeManager::openProject(const QString &fileName, QString *errorString)
 {
     Utils::FileName file = Utils::FileName::fromString(fileName);
@@ -194,3 +382,53 @@ QString CMakeManager::findCbpFile(const QDir &directory)
     }
     return file;
 }
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+
+void CMakeProjectPlugin::testCMakeObjectFile_data()
+{
+    QTest::addColumn<QString>("targetSourceDirectory");
+    QTest::addColumn<QString>("workingDirectory");
+    QTest::addColumn<QString>("sourceFile");
+    QTest::addColumn<QString>("objectFile");
+
+    const auto addRow = [](const char *name, const char *targetSourceDirectory,
+                           const char *workingDirectory, const char *sourceFile, const char *objectFile) {
+        QTest::newRow(name) << QString::fromLatin1(targetSourceDirectory)
+                            << QString::fromLatin1(workingDirectory)
+                            << QString::fromLatin1(sourceFile) << QString::fromLatin1(objectFile);
+    };
+    addRow("top level", "/project", "/build", "/project/main.cpp", "CMakeFiles/app.dir/main.cpp");
+    addRow("sub directory", "/project/src/app", "/build/bin", "/project/src/app/ui/main.cpp",
+           "src/app/CMakeFiles/app.dir/ui/main.cpp");
+    addRow("outside of the target directory", "/project/src/app", "/build/src/app",
+           "/project/common/util.cpp", "src/app/CMakeFiles/app.dir/__/__/common/util.cpp");
+    addRow("generated", "/project/src/app", "/build/src/app", "/build/src/app/moc_main.cpp",
+           "src/app/CMakeFiles/app.dir/moc_main.cpp");
+    addRow("external source directory", "/external/lib", "/build/external", "/external/lib/lib.cpp",
+           "external/CMakeFiles/app.dir/lib.cpp");
+}
+
+void CMakeProjectPlugin::testCMakeObjectFile()
+{
+    QFETCH(QString, targetSourceDirectory);
+    QFETCH(QString, workingDirectory);
+    QFETCH(QString, sourceFile);
+    QFETCH(QString, objectFile);
+
+    CMakeBuildTarget target;
+    target.title = QLatin1String("app");
+    target.sourceDirectory = targetSourceDirectory;
+    target.workingDirectory = workingDirectory;
+
+    objectFile += QLatin1String(Utils::HostOsInfo::isWindowsHost() ? ".obj" : ".o");
+    QCOMPARE(CMakeManager::objectFile(target, Utils::FileName::fromString(sourceFile),
+                                      Utils::FileName::fromString(QLatin1String("/project")),
+                                      Utils::FileName::fromString(QLatin1String("/build"))),
+             objectFile);
+}
+
+#endif
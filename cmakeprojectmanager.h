@@ -35,10 +35,14 @@ QT_END_NAMESPACE
 namespace ProjectExplorer { class Node; }
 namespace Utils {
 class Environment;
+class FileName;
 class QtcProcess;
 } // namespace Utils
 
 namespace CMakeProjectManager {
+
+class CMakeBuildTarget;
+
 namespace Internal {
 
 class CMakeSettingsPage;
@@ -57,14 +61,26 @@ public:
                               const QDir &buildDirectory, const Utils::Environment &env);
     static QString findCbpFile(const QDir &);
 
+    // The object file CMake compiles sourceFile of target into, relative to the build directory
+    static QString objectFile(const CMakeBuildTarget &target, const Utils::FileName &sourceFile,
+                              const Utils::FileName &sourceDirectory,
+                              const Utils::FileName &buildDirectory);
+
 private:
     void updateCmakeActions();
     void clearCMakeCache(ProjectExplorer::Project *project);
     void runCMake(ProjectExplorer::Project *project);
+    void showBuildReport(ProjectExplorer::Project *project);
+    void compileFile(ProjectExplorer::Project *project, const Utils::FileName &sourceFile);
+    void buildAffectedTargets(ProjectExplorer::Project *project);
 
     QAction *m_runCMakeAction;
     QAction *m_clearCMakeCacheAction;
     QAction *m_runCMakeActionContextMenu;
+    QAction *m_showBuildReportAction;
+    QAction *m_compileCurrentFileAction;
+    QAction *m_compileFileActionContextMenu;
+    QAction *m_buildAffectedTargetsAction;
 };
 
 } // namespace Internal
@@ -4,6 +4,8 @@ QTCREATOR_SOURCES = $$(QTC_SOURCE)
 ## set the QTC_BUILD environment variable to override the setting here
 IDE_BUILD_TREE = $$(QTC_BUILD_INPLACE)
 
+QT += concurrent
+
 DEFINES += CMAKEPROJECTMANAGER_LIBRARY
 include(cmakeprojectmanager_dependencies.pri)
 include($$QTCREATOR_SOURCES/src/qtcreatorplugin.pri)
@@ -12,7 +14,10 @@ include($$QTCREATOR_SOURCES/src/qtcreatorplugin.pri)
 INCLUDEPATH += $$QTCREATOR_SOURCES/src/plugins/texteditor
 
 HEADERS = builddirmanager.h \
+    cmakeaffectedtargets.h \
     cmakebuildinfo.h \
+    cmakebuildreport.h \
+    cmakebuildreportdialog.h \
     cmakebuildstep.h \
     cmakeconfigitem.h \
     cmakeproject.h \
@@ -20,53 +25,70 @@ HEADERS = builddirmanager.h \
     cmakeprojectmanager.h \
     cmakeprojectconstants.h \
     cmakeprojectnodes.h \
+    cmakeprojectsnapshot.h \
     cmakerunconfiguration.h \
     cmakebuildconfiguration.h \
     cmakeeditor.h \
     cmakelocatorfilter.h \
     cmakefilecompletionassist.h \
+    cmaketaskaggregator.h \
     cmaketool.h \
     cmakeparser.h \
     cmakesettingspage.h \
     cmaketoolmanager.h \
     cmake_global.h \
     cmakeinlineeditordialog.h \
+    cmakekeyworddatabase.h \
     cmakekitinformation.h \
     cmakekitconfigwidget.h \
     cmakecbpparser.h \
+    cmakecbpscanner.h \
+    cmakecompilercache.h \
+    cmakecompletionindex.h \
     cmakefile.h \
     cmakebuildsettingswidget.h \
     cmakeindenter.h \
     cmakeautocompleter.h \
     configmodel.h \
-    cmaketoolchaininfo.h
+    cmaketoolchaininfo.h \
+    cmaketargetflags.h
 
 SOURCES = builddirmanager.cpp \
+    cmakeaffectedtargets.cpp \
+    cmakebuildreport.cpp \
+    cmakebuildreportdialog.cpp \
     cmakebuildstep.cpp \
     cmakeconfigitem.cpp \
     cmakeproject.cpp \
     cmakeprojectplugin.cpp \
     cmakeprojectmanager.cpp \
     cmakeprojectnodes.cpp \
+    cmakeprojectsnapshot.cpp \
     cmakerunconfiguration.cpp \
     cmakebuildconfiguration.cpp \
     cmakeeditor.cpp \
     cmakelocatorfilter.cpp \
     cmakefilecompletionassist.cpp \
+    cmaketaskaggregator.cpp \
     cmaketool.cpp \
     cmakeparser.cpp \
     cmakesettingspage.cpp \
     cmaketoolmanager.cpp \
     cmakeinlineeditordialog.cpp \
+    cmakekeyworddatabase.cpp \
     cmakekitinformation.cpp \
     cmakekitconfigwidget.cpp \
     cmakecbpparser.cpp \
+    cmakecbpscanner.cpp \
+    cmakecompilercache.cpp \
+    cmakecompletionindex.cpp \
     cmakefile.cpp \
     cmakebuildsettingswidget.cpp \
     cmakeindenter.cpp \
     cmakeautocompleter.cpp \
     configmodel.cpp \
-    cmaketoolchaininfo.cpp
+    cmaketoolchaininfo.cpp \
+    cmaketargetflags.cpp
 
 LIBS+=-L${QTC_BUILD}/lib/qtcreator \
     -L${QTC_BUILD}/lib/qtcreator/plugins
@@ -59,6 +59,7 @@ bool CMakeProjectPlugin::initialize(const QStringList & /*arguments*/, QString *
     ProjectExplorer::KitManager::registerKitInformation(new CMakeKitInformation);
     ProjectExplorer::KitManager::registerKitInformation(new CMakeGeneratorKitInformation);
     ProjectExplorer::KitManager::registerKitInformation(new CMakeConfigurationKitInformation);
+    ProjectExplorer::KitManager::registerKitInformation(new CMakeCompilerCacheKitInformation);
 
     return true;
 }
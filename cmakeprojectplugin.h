@@ -49,6 +49,50 @@ public:
 private slots:
     void testCMakeParser_data();
     void testCMakeParser();
+    void testCMakeParserWithoutWarnings();
+    void testCMakeParserBenchmark_data();
+    void testCMakeParserBenchmark();
+    void testCMakeTaskAggregator();
+
+    void testCMakeTargetFlagsFileName_data();
+    void testCMakeTargetFlagsFileName();
+
+    void testCMakeTargetDirectoryIndex_data();
+    void testCMakeTargetDirectoryIndex();
+    void testCMakeTargetDirectoryIndexBenchmark();
+
+    void testCMakeCbpScanner();
+    void testCMakeCbpScannerBenchmark_data();
+    void testCMakeCbpScannerBenchmark();
+
+    void testCMakeToolPathPrefixMapping();
+    void testCMakeToolCapabilities();
+    void testCMakeKeywordDatabase();
+    void testCMakeCompletionIndex();
+    void testCMakeCompletionIndexBenchmark();
+
+    void testCMakeBuildStepProgress_data();
+    void testCMakeBuildStepProgress();
+    void testCMakeBuildStepNinjaStatus();
+    void testCMakeBuildStepJobCount_data();
+    void testCMakeBuildStepJobCount();
+    void testCMakeBuildStepJobMemory();
+    void testCMakeBuildStepJobCountArgument();
+    void testCMakeBuildStepTargetGroups();
+    void testCMakeBuildStepExclusiveTargets();
+    void testCMakeBuildStepProgressBenchmark_data();
+    void testCMakeBuildStepProgressBenchmark();
+
+    void testCMakeNinjaLog();
+    void testCMakeBuildEstimate();
+    void testCMakeAffectedTargets();
+
+    void testCMakeObjectFile_data();
+    void testCMakeObjectFile();
+
+    void testCMakeCompilerCacheStatistics_data();
+    void testCMakeCompilerCacheStatistics();
+    void testCMakeCompilerCacheConfigureArguments();
 #endif
 };
 
@@ -0,0 +1,175 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmakeprojectsnapshot.h"
+#include "cmaketargetflags.h"
+
+#include <utils/algorithm.h>
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace CMakeProjectManager {
+
+// Found through argument dependent lookup by the QList stream operators
+static QDataStream &operator<<(QDataStream &stream, const CMakeBuildTarget &target)
+{
+    return stream << target.title << target.executable << qint32(target.targetType)
+                  << target.workingDirectory << target.sourceDirectory << target.makeCommand
+                  << target.makeCleanCommand << target.includeFiles << target.compilerOptions
+                  << target.defines << target.files;
+}
+
+static QDataStream &operator>>(QDataStream &stream, CMakeBuildTarget &target)
+{
+    qint32 targetType;
+    stream >> target.title >> target.executable >> targetType
+           >> target.workingDirectory >> target.sourceDirectory >> target.makeCommand
+           >> target.makeCleanCommand >> target.includeFiles >> target.compilerOptions
+           >> target.defines >> target.files;
+    target.targetType = TargetType(targetType);
+    return stream;
+}
+
+static QDataStream &operator<<(QDataStream &stream, const CMakeConfigItem &item)
+{
+    return stream << item.key << qint32(item.type) << item.isAdvanced << item.value
+                  << item.documentation;
+}
+
+static QDataStream &operator>>(QDataStream &stream, CMakeConfigItem &item)
+{
+    qint32 type;
+    stream >> item.key >> type >> item.isAdvanced >> item.value >> item.documentation;
+    item.type = CMakeConfigItem::Type(type);
+    return stream;
+}
+
+namespace Internal {
+
+static QDataStream &operator<<(QDataStream &stream, const CMakeProjectSnapshot::File &file)
+{
+    return stream << file.path.toString() << qint32(file.type) << file.isGenerated;
+}
+
+static QDataStream &operator>>(QDataStream &stream, CMakeProjectSnapshot::File &file)
+{
+    QString path;
+    qint32 type;
+    stream >> path >> type >> file.isGenerated;
+    file.path = Utils::FileName::fromString(path);
+    file.type = ProjectExplorer::FileType(type);
+    return stream;
+}
+
+namespace {
+
+const quint32 SNAPSHOT_MAGIC = 0x43437053; // "CCpS"
+const quint32 SNAPSHOT_VERSION = 1;
+
+QStringList toStringList(const QList<Utils::FileName> &fileNames)
+{
+    return Utils::transform(fileNames, &Utils::FileName::toString);
+}
+
+} // namespace
+
+QString CMakeProjectSnapshot::fileName(const Utils::FileName &buildDirectory)
+{
+    // Goes away with the CMake cache
+    return buildDirectory.toString() + QLatin1String("/CMakeFiles/QtCreatorProjectSnapshot.bin");
+}
+
+bool CMakeProjectSnapshot::save(const QString &fileName, const CMakeTargetFlagsCache &flagsCache) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << SNAPSHOT_MAGIC << SNAPSHOT_VERSION;
+    stream << sourceDirectory << cbpFile << cbpFileLastModified << kitId << cmakeToolId;
+    stream << projectName << buildTargets << files << toStringList(watchedFiles)
+           << parsedConfiguration << parsedConfigurationLastModified;
+    flagsCache.save(stream);
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool CMakeProjectSnapshot::load(const QString &fileName, CMakeTargetFlagsCache *flagsCache)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC
+            || version != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    CMakeProjectSnapshot snapshot;
+    QStringList watchedFiles;
+    stream >> snapshot.sourceDirectory >> snapshot.cbpFile >> snapshot.cbpFileLastModified
+           >> snapshot.kitId >> snapshot.cmakeToolId;
+    stream >> snapshot.projectName >> snapshot.buildTargets >> snapshot.files >> watchedFiles
+           >> snapshot.parsedConfiguration >> snapshot.parsedConfigurationLastModified;
+    snapshot.watchedFiles = Utils::transform(watchedFiles, &Utils::FileName::fromString);
+    if (stream.status() != QDataStream::Ok || !snapshot.isValid())
+        return false;
+    if (flagsCache && !flagsCache->restore(stream))
+        return false;
+
+    *this = snapshot;
+    return true;
+}
+
+bool CMakeProjectSnapshot::isUpToDate() const
+{
+    const QFileInfo cbpFileInfo(cbpFile);
+    if (!cbpFileInfo.exists() || cbpFileInfo.lastModified() != cbpFileLastModified)
+        return false;
+
+    // The parsed configuration is checked against CMakeCache.txt whenever it is used
+
+    // Same rule as in BuildDirManager::parse()
+    return !Utils::anyOf(watchedFiles, [&cbpFileInfo](const Utils::FileName &f) {
+        return f.toFileInfo().lastModified() > cbpFileInfo.lastModified();
+    });
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "cmakeconfigitem.h"
+#include "cmakeproject.h"
+
+#include <projectexplorer/projectnodes.h>
+#include <utils/fileutils.h>
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+class CMakeTargetFlagsCache;
+
+// What BuildDirManager extracted from a build directory. It is stored in the build directory,
+// so that a reopened project can be shown without running CMake or parsing its output.
+// The file is versioned, so that snapshots of other versions are ignored.
+class CMakeProjectSnapshot
+{
+public:
+    class File
+    {
+    public:
+        Utils::FileName path;
+        ProjectExplorer::FileType type = ProjectExplorer::UnknownFileType;
+        bool isGenerated = false;
+    };
+
+    // What the data was extracted from
+    QString sourceDirectory;
+    QString cbpFile;
+    QDateTime cbpFileLastModified;
+    QByteArray kitId;
+    QByteArray cmakeToolId;
+
+    QString projectName;
+    QList<CMakeBuildTarget> buildTargets;
+    QList<File> files;
+    QList<Utils::FileName> watchedFiles;
+    CMakeConfig parsedConfiguration;
+    QDateTime parsedConfigurationLastModified;
+
+    bool isValid() const { return !cbpFile.isEmpty(); }
+
+    static QString fileName(const Utils::FileName &buildDirectory);
+
+    bool save(const QString &fileName, const CMakeTargetFlagsCache &flagsCache) const;
+    bool load(const QString &fileName, CMakeTargetFlagsCache *flagsCache);
+
+    // Whether the snapshot still matches the build directory. This stats all project files,
+    // so better call it from a worker thread.
+    bool isUpToDate() const;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
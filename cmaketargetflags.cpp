@@ -0,0 +1,455 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmaketargetflags.h"
+#include "cmakeproject.h"
+
+#include <utils/qtcprocess.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+struct FlagsMakeRequest
+{
+    QString fileName;
+    QDateTime cachedLastModified;
+};
+
+struct FlagsMakeResult
+{
+    QString fileName;
+    QDateTime lastModified;
+    CMakeTargetFlags flags;
+    bool exists = false;
+    bool upToDate = false;
+};
+
+QStringList splitFlags(const QString &value)
+{
+    return Utils::QtcProcess::splitArgs(value);
+}
+
+QByteArray toDefines(const QStringList &args)
+{
+    QByteArray result;
+    for (int i = 0; i < args.count(); ++i) {
+        QString define;
+        const QString &arg = args.at(i);
+        if (arg == QLatin1String("-D") || arg == QLatin1String("/D")) {
+            if (i + 1 < args.count())
+                define = args.at(++i);
+        } else if (arg.startsWith(QLatin1String("-D")) || arg.startsWith(QLatin1String("/D"))) {
+            define = arg.mid(2);
+        }
+        if (define.isEmpty())
+            continue;
+
+        const int assignIndex = define.indexOf(QLatin1Char('='));
+        if (assignIndex != -1)
+            define[assignIndex] = QLatin1Char(' ');
+        result.append("#define ");
+        result.append(define.toUtf8());
+        result.append('\n');
+    }
+    return result;
+}
+
+QStringList toIncludePaths(const QStringList &args)
+{
+    QStringList result;
+    for (int i = 0; i < args.count(); ++i) {
+        const QString &arg = args.at(i);
+        QString path;
+        if (arg == QLatin1String("-I") || arg == QLatin1String("/I")
+                || arg == QLatin1String("-isystem")) {
+            if (i + 1 < args.count())
+                path = args.at(++i);
+        } else if (arg.startsWith(QLatin1String("-isystem"))) {
+            path = arg.mid(8);
+        } else if (arg.startsWith(QLatin1String("-I")) || arg.startsWith(QLatin1String("/I"))) {
+            path = arg.mid(2);
+        }
+        if (!path.isEmpty())
+            result.append(QDir::fromNativeSeparators(path));
+    }
+    return result;
+}
+
+// Handles the "<LANG>_FLAGS", "<LANG>_DEFINES" and "<LANG>_INCLUDES" lines of flags.make.
+void applyFlagsMakeLine(const QByteArray &key, const QString &value, CMakeTargetFlags &flags)
+{
+    if (key == "CXX_FLAGS") {
+        flags.cxxFlags = splitFlags(value);
+    } else if (key == "C_FLAGS") {
+        flags.cFlags = splitFlags(value);
+    } else if (key == "CXX_DEFINES" || key == "C_DEFINES") {
+        if (flags.defines.isEmpty())
+            flags.defines = toDefines(splitFlags(value));
+    } else if (key == "CXX_INCLUDES" || key == "C_INCLUDES") {
+        if (flags.includePaths.isEmpty())
+            flags.includePaths = toIncludePaths(splitFlags(value));
+    }
+}
+
+// "/usr/bin/make -f "/build/src/Makefile" app/fast" -> "/build/src"
+QString makefileDirectory(const QString &makeCommand)
+{
+    const QStringList args = splitFlags(makeCommand);
+    for (int i = 0; i < args.count(); ++i) {
+        QString makefile;
+        if (args.at(i) == QLatin1String("-f")) {
+            if (i + 1 < args.count())
+                makefile = args.at(i + 1);
+        } else if (args.at(i).startsWith(QLatin1String("-f"))) {
+            makefile = args.at(i).mid(2);
+        }
+        makefile = QDir::fromNativeSeparators(makefile);
+        const int slash = makefile.lastIndexOf(QLatin1Char('/'));
+        if (slash > 0)
+            return makefile.left(slash);
+    }
+    return QString();
+}
+
+FlagsMakeResult readFlagsMake(const FlagsMakeRequest &request)
+{
+    FlagsMakeResult result;
+    result.fileName = request.fileName;
+
+    const QFileInfo fi(request.fileName);
+    if (!fi.exists())
+        return result;
+
+    result.exists = true;
+    result.lastModified = fi.lastModified();
+    if (result.lastModified == request.cachedLastModified) {
+        result.upToDate = true;
+        return result;
+    }
+
+    QFile file(request.fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        result.exists = false;
+        return result;
+    }
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const int assignIndex = line.indexOf('=');
+        if (assignIndex == -1)
+            continue;
+        applyFlagsMakeLine(line.left(assignIndex).trimmed(),
+                           QString::fromUtf8(line.mid(assignIndex + 1).trimmed()), result.flags);
+    }
+    return result;
+}
+
+} // namespace
+
+bool CMakeTargetFlags::isEmpty() const
+{
+    return cFlags.isEmpty() && cxxFlags.isEmpty() && defines.isEmpty() && includePaths.isEmpty();
+}
+
+QHash<QString, CMakeTargetFlags> CMakeTargetFlagsCache::flags(const QList<CMakeBuildTarget> &targets,
+                                                              const QString &sourceDirectory,
+                                                              const QString &buildDirectory)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QList<FlagsMakeRequest> requests;
+    foreach (const CMakeBuildTarget &target, targets) {
+        const QString fileName = flagsMakeFileName(target, sourceDirectory, buildDirectory);
+        if (fileName.isEmpty())
+            continue;
+        FlagsMakeRequest request;
+        request.fileName = fileName;
+        request.cachedLastModified = m_flagsMake.value(fileName).lastModified;
+        requests.append(request);
+    }
+
+    // Stat and (re-)read all flags.make files at once:
+    const QList<FlagsMakeResult> results = QtConcurrent::blockingMapped(requests, readFlagsMake);
+
+    QHash<QString, Entry> entries; // Drops the entries of targets that went away
+    foreach (const FlagsMakeResult &r, results) {
+        if (r.upToDate) {
+            entries.insert(r.fileName, m_flagsMake.value(r.fileName));
+            continue;
+        }
+        Entry entry;
+        entry.lastModified = r.lastModified;
+        entry.flags = r.flags;
+        entry.exists = r.exists;
+        entries.insert(r.fileName, entry);
+    }
+    m_flagsMake = entries;
+
+    QHash<QString, CMakeTargetFlags> result;
+    bool needsNinjaFlags = false;
+    foreach (const CMakeBuildTarget &target, targets) {
+        auto it = m_flagsMake.constFind(flagsMakeFileName(target, sourceDirectory, buildDirectory));
+        if (it != m_flagsMake.constEnd() && it->exists)
+            result.insert(target.title, it->flags);
+        else
+            needsNinjaFlags = true;
+    }
+
+    if (needsNinjaFlags) {
+        // No flags.make: Try to get the flags from build.ninja instead
+        const QHash<QString, CMakeTargetFlags> ninjaFlags = readNinjaFlags(buildDirectory);
+        for (auto it = ninjaFlags.constBegin(); it != ninjaFlags.constEnd(); ++it) {
+            if (!result.contains(it.key()))
+                result.insert(it.key(), it.value());
+        }
+    }
+
+    return result;
+}
+
+void CMakeTargetFlagsCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_flagsMake.clear();
+    m_buildNinjaFile.clear();
+    m_buildNinjaLastModified = QDateTime();
+    m_ninjaFlags.clear();
+}
+
+static QDataStream &operator<<(QDataStream &stream, const CMakeTargetFlags &flags)
+{
+    return stream << flags.cFlags << flags.cxxFlags << flags.defines << flags.includePaths;
+}
+
+static QDataStream &operator>>(QDataStream &stream, CMakeTargetFlags &flags)
+{
+    return stream >> flags.cFlags >> flags.cxxFlags >> flags.defines >> flags.includePaths;
+}
+
+void CMakeTargetFlagsCache::save(QDataStream &stream) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    stream << qint32(m_flagsMake.size());
+    for (auto it = m_flagsMake.constBegin(); it != m_flagsMake.constEnd(); ++it)
+        stream << it.key() << it->lastModified << it->flags << it->exists;
+    stream << m_buildNinjaFile << m_buildNinjaLastModified << m_ninjaFlags;
+}
+
+bool CMakeTargetFlagsCache::restore(QDataStream &stream)
+{
+    QHash<QString, Entry> flagsMake;
+    qint32 count;
+    stream >> count;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        Entry entry;
+        stream >> fileName >> entry.lastModified >> entry.flags >> entry.exists;
+        flagsMake.insert(fileName, entry);
+    }
+    QString buildNinjaFile;
+    QDateTime buildNinjaLastModified;
+    QHash<QString, CMakeTargetFlags> ninjaFlags;
+    stream >> buildNinjaFile >> buildNinjaLastModified >> ninjaFlags;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    m_flagsMake = flagsMake;
+    m_buildNinjaFile = buildNinjaFile;
+    m_buildNinjaLastModified = buildNinjaLastModified;
+    m_ninjaFlags = ninjaFlags;
+    return true;
+}
+
+QString CMakeTargetFlagsCache::flagsMakeFileName(const CMakeBuildTarget &target,
+                                                const QString &sourceDirectory,
+                                                const QString &buildDirectory)
+{
+    if (target.title.isEmpty())
+        return QString();
+
+    // The make command of a target runs the Makefile of its binary directory
+    QString binaryDirectory = makefileDirectory(target.makeCommand);
+    if (binaryDirectory.isEmpty() && !target.sourceDirectory.isEmpty()
+            && !sourceDirectory.isEmpty() && !buildDirectory.isEmpty()) {
+        const QString relative = QDir(sourceDirectory).relativeFilePath(target.sourceDirectory);
+        if (!relative.startsWith(QLatin1String("..")))
+            binaryDirectory = QDir::cleanPath(buildDirectory + QLatin1Char('/') + relative);
+    }
+    if (binaryDirectory.isEmpty())
+        binaryDirectory = target.workingDirectory;
+    if (binaryDirectory.isEmpty())
+        return QString();
+    return QDir::fromNativeSeparators(binaryDirectory)
+            + QLatin1String("/CMakeFiles/") + target.title + QLatin1String(".dir/flags.make");
+}
+
+QHash<QString, CMakeTargetFlags> CMakeTargetFlagsCache::readNinjaFlags(const QString &buildDirectory)
+{
+    const QString fileName = QDir::fromNativeSeparators(buildDirectory) + QLatin1String("/build.ninja");
+    const QFileInfo fi(fileName);
+    if (!fi.exists()) {
+        m_buildNinjaFile.clear();
+        m_ninjaFlags.clear();
+        return m_ninjaFlags;
+    }
+
+    if (fileName == m_buildNinjaFile && fi.lastModified() == m_buildNinjaLastModified)
+        return m_ninjaFlags;
+
+    m_buildNinjaFile = fileName;
+    m_buildNinjaLastModified = fi.lastModified();
+    m_ninjaFlags.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return m_ninjaFlags;
+
+    enum Language { NoLanguage, CLanguage, CxxLanguage };
+
+    const QByteArray targetSignature = "# Object build statements for ";
+    QString currentTarget;
+    Language language = NoLanguage;
+
+    while (!file.atEnd()) {
+        // 1. Look for a block that refers to a target
+        // 2. Look for a build rule which invokes the C or C++ compiler
+        // 3. Take the FLAGS, DEFINES and INCLUDES definitions of that rule
+        const QByteArray line = file.readLine().trimmed();
+        if (line.startsWith('#')) {
+            if (line.startsWith(targetSignature))
+                currentTarget = QString::fromUtf8(line.mid(line.lastIndexOf(' ') + 1));
+            continue;
+        }
+        if (currentTarget.isEmpty())
+            continue;
+
+        if (line.startsWith("build ")) {
+            if (line.contains("CXX_COMPILER"))
+                language = CxxLanguage;
+            else if (line.contains("C_COMPILER"))
+                language = CLanguage;
+            else
+                language = NoLanguage;
+            continue;
+        }
+        if (language == NoLanguage)
+            continue;
+
+        const int assignIndex = line.indexOf('=');
+        if (assignIndex == -1)
+            continue;
+        const QByteArray key = line.left(assignIndex).trimmed();
+        const QString value = QString::fromUtf8(line.mid(assignIndex + 1).trimmed());
+
+        CMakeTargetFlags &flags = m_ninjaFlags[currentTarget];
+        if (key == "FLAGS") {
+            QStringList &languageFlags = (language == CxxLanguage) ? flags.cxxFlags : flags.cFlags;
+            if (languageFlags.isEmpty())
+                languageFlags = splitFlags(value);
+        } else if (key == "DEFINES") {
+            if (flags.defines.isEmpty())
+                flags.defines = toDefines(splitFlags(value));
+        } else if (key == "INCLUDES") {
+            if (flags.includePaths.isEmpty())
+                flags.includePaths = toIncludePaths(splitFlags(value));
+        }
+    }
+    return m_ninjaFlags;
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+void CMakeProjectPlugin::testCMakeTargetFlagsFileName_data()
+{
+    QTest::addColumn<QString>("targetSourceDirectory");
+    QTest::addColumn<QString>("workingDirectory");
+    QTest::addColumn<QString>("makeCommand");
+    QTest::addColumn<QString>("flagsMake");
+
+    const auto addRow = [](const char *name, const char *targetSourceDirectory,
+                           const char *workingDirectory, const char *makeCommand,
+                           const char *flagsMake) {
+        QTest::newRow(name) << QString::fromLatin1(targetSourceDirectory)
+                            << QString::fromLatin1(workingDirectory)
+                            << QString::fromLatin1(makeCommand) << QString::fromLatin1(flagsMake);
+    };
+    addRow("top level", "/project", "/build", "/usr/bin/make -f \"/build/Makefile\" app/fast",
+           "/build/CMakeFiles/app.dir/flags.make");
+    addRow("runtime output directory", "/project/src/app", "/build/bin",
+           "/usr/bin/make -f \"/build/src/app/Makefile\" app/fast",
+           "/build/src/app/CMakeFiles/app.dir/flags.make");
+    addRow("runtime output directory without make command", "/project/src/app", "/build/bin", "",
+           "/build/src/app/CMakeFiles/app.dir/flags.make");
+    addRow("external source directory", "/external/lib", "/build/external",
+           "/usr/bin/make -f/build/external/Makefile app/fast",
+           "/build/external/CMakeFiles/app.dir/flags.make");
+    addRow("external source directory without make command", "/external/lib", "/build/external", "",
+           "/build/external/CMakeFiles/app.dir/flags.make");
+}
+
+void CMakeProjectPlugin::testCMakeTargetFlagsFileName()
+{
+    QFETCH(QString, targetSourceDirectory);
+    QFETCH(QString, workingDirectory);
+    QFETCH(QString, makeCommand);
+    QFETCH(QString, flagsMake);
+
+    CMakeBuildTarget target;
+    target.title = QLatin1String("app");
+    target.sourceDirectory = targetSourceDirectory;
+    target.workingDirectory = workingDirectory;
+    target.makeCommand = makeCommand;
+
+    QCOMPARE(CMakeTargetFlagsCache::flagsMakeFileName(target, QLatin1String("/project"),
+                                                      QLatin1String("/build")),
+             flagsMake);
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#endif
@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+QT_FORWARD_DECLARE_CLASS(QDataStream)
+
+namespace CMakeProjectManager {
+
+class CMakeBuildTarget;
+
+namespace Internal {
+
+class CMakeTargetFlags
+{
+public:
+    QStringList cFlags;
+    QStringList cxxFlags;
+    QByteArray defines; // "#define NAME VALUE" lines, as expected by the code model
+    QStringList includePaths;
+
+    bool isEmpty() const;
+};
+
+// Reads the compiler flags of build targets from the files generated by CMake
+// (CMakeFiles/<target>.dir/flags.make for Makefile generators, build.ninja for Ninja).
+// Results are kept across reparses and only re-read when the generated file changed.
+// The cache may be used from worker threads.
+class CMakeTargetFlagsCache
+{
+public:
+    QHash<QString, CMakeTargetFlags> flags(const QList<CMakeBuildTarget> &targets,
+                                           const QString &sourceDirectory,
+                                           const QString &buildDirectory);
+    void clear();
+
+    // For CMakeProjectSnapshot. Restored entries are checked against the files like any other.
+    void save(QDataStream &stream) const;
+    bool restore(QDataStream &stream);
+
+    // In the binary directory of the CMakeLists.txt that defined the target, which is not its
+    // working directory if that is a runtime output directory
+    static QString flagsMakeFileName(const CMakeBuildTarget &target, const QString &sourceDirectory,
+                                     const QString &buildDirectory);
+
+private:
+    struct Entry {
+        QDateTime lastModified;
+        CMakeTargetFlags flags;
+        bool exists = false;
+    };
+
+    QHash<QString, CMakeTargetFlags> readNinjaFlags(const QString &buildDirectory);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_flagsMake; // flags.make path -> contents
+    QString m_buildNinjaFile;
+    QDateTime m_buildNinjaLastModified;
+    QHash<QString, CMakeTargetFlags> m_ninjaFlags; // target title -> flags
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,176 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "cmaketaskaggregator.h"
+
+#include <projectexplorer/projectexplorerconstants.h>
+#include <projectexplorer/taskhub.h>
+
+namespace {
+const int BATCH_INTERVAL = 250; // ms
+} // namespace
+
+using namespace ProjectExplorer;
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+CMakeTaskAggregator::CMakeTaskAggregator(int maxTasks) :
+    m_maxTasks(maxTasks),
+    m_addTask([](const Task &task) { TaskHub::addTask(task); }),
+    m_removeTask([](const Task &task) { TaskHub::removeTask(task); })
+{
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setInterval(BATCH_INTERVAL);
+    connect(&m_batchTimer, &QTimer::timeout, this, &CMakeTaskAggregator::flush);
+}
+
+void CMakeTaskAggregator::setTaskHandlers(const TaskHandler &addTask, const TaskHandler &removeTask)
+{
+    m_addTask = addTask;
+    m_removeTask = removeTask;
+}
+
+void CMakeTaskAggregator::addTask(const Task &task)
+{
+    const QString key = QString::number(task.type) + QLatin1Char('\n') + task.file.toString()
+            + QLatin1Char('\n') + QString::number(task.line) + QLatin1Char('\n') + task.description;
+    const auto it = m_entryIndex.constFind(key);
+    if (it != m_entryIndex.constEnd()) {
+        ++m_entries[it.value()].count;
+        return;
+    }
+    if (m_entries.size() >= m_maxTasks) {
+        ++m_overflow;
+        return;
+    }
+
+    Entry entry;
+    entry.task = task;
+    entry.description = task.description;
+    m_entryIndex.insert(key, m_entries.size());
+    m_pending.append(m_entries.size());
+    m_entries.append(entry);
+    if (!m_batchTimer.isActive())
+        m_batchTimer.start();
+}
+
+void CMakeTaskAggregator::flush()
+{
+    m_batchTimer.stop();
+    foreach (int index, m_pending) {
+        Entry &entry = m_entries[index];
+        entry.task = withCount(entry);
+        entry.addedCount = entry.count;
+        m_addTask(entry.task);
+    }
+    m_pending.clear();
+}
+
+void CMakeTaskAggregator::finish()
+{
+    flush();
+
+    // A replacement keeps the id of the task, and with it the position in the Issues pane
+    for (Entry &entry : m_entries) {
+        if (entry.count == entry.addedCount)
+            continue;
+        m_removeTask(entry.task);
+        entry.task = withCount(entry);
+        entry.addedCount = entry.count;
+        m_addTask(entry.task);
+    }
+
+    if (m_overflow > 0) {
+        m_addTask(Task(Task::Warning,
+                       tr("%n more CMake issue(s) not listed, see General Messages.", 0, m_overflow),
+                       Utils::FileName(), -1, Constants::TASK_CATEGORY_BUILDSYSTEM));
+        m_overflow = 0;
+    }
+}
+
+void CMakeTaskAggregator::clear()
+{
+    m_batchTimer.stop();
+    m_entryIndex.clear();
+    m_entries.clear();
+    m_pending.clear();
+    m_overflow = 0;
+}
+
+Task CMakeTaskAggregator::withCount(const Entry &entry) const
+{
+    Task task = entry.task;
+    task.description = entry.count > 1
+            ? tr("%1 (%n times)", 0, entry.count).arg(entry.description)
+            : entry.description;
+    return task;
+}
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QMap>
+#include <QTest>
+
+void CMakeProjectPlugin::testCMakeTaskAggregator()
+{
+    // Ordered by id like the Issues pane
+    QMap<unsigned int, Task> taskMap;
+    CMakeTaskAggregator aggregator(2);
+    aggregator.setTaskHandlers([&taskMap](const Task &task) { taskMap.insert(task.taskId, task); },
+                               [&taskMap](const Task &task) { taskMap.remove(task.taskId); });
+
+    const Core::Id category = Constants::TASK_CATEGORY_BUILDSYSTEM;
+    const Utils::FileName module = Utils::FileName::fromString(QLatin1String("/project/cmake/Module.cmake"));
+    const Task policy(Task::Warning, QLatin1String("Policy CMP0048 is not set."), module, 12, category);
+    const Task error(Task::Error, QLatin1String("Unknown CMake command \"foo\"."), module, 30, category);
+
+    aggregator.addTask(policy);
+    aggregator.addTask(policy);
+    QVERIFY(taskMap.isEmpty());
+    aggregator.flush();
+    QList<Task> tasks = taskMap.values();
+    QCOMPARE(tasks.size(), 1);
+    QCOMPARE(tasks.at(0).description, QString::fromLatin1("Policy CMP0048 is not set. (2 times)"));
+
+    // The same warning from another line is another task
+    aggregator.addTask(Task(Task::Warning, policy.description, module, 13, category));
+    aggregator.addTask(policy);
+    aggregator.addTask(error);
+    aggregator.addTask(error);
+    aggregator.finish();
+    tasks = taskMap.values();
+    QCOMPARE(tasks.size(), 3);
+    QCOMPARE(tasks.at(0).description, QString::fromLatin1("Policy CMP0048 is not set. (3 times)"));
+    QCOMPARE(tasks.at(0).taskId, policy.taskId);
+    QCOMPARE(tasks.at(1).line, 13);
+    QCOMPARE(tasks.at(2).description, QString::fromLatin1("2 more CMake issue(s) not listed, see General Messages."));
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
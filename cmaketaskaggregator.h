@@ -0,0 +1,83 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <projectexplorer/task.h>
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Collects the tasks of one CMake run on their way to the TaskHub. Identical tasks are
+// listed once with the number of times they occurred, at most maxTasks are listed, and
+// they are added in batches instead of one by one while CMake is still writing them.
+class CMakeTaskAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    using TaskHandler = std::function<void(const ProjectExplorer::Task &)>;
+
+    explicit CMakeTaskAggregator(int maxTasks = 1000);
+
+    // Where tasks go, the TaskHub by default
+    void setTaskHandlers(const TaskHandler &addTask, const TaskHandler &removeTask);
+
+    void addTask(const ProjectExplorer::Task &task);
+    void flush();
+    void finish(); // updates the counts of listed tasks and says how many were left out
+    void clear();
+
+private:
+    class Entry
+    {
+    public:
+        ProjectExplorer::Task task; // as added, so that it can be replaced later
+        QString description;
+        int count = 1;
+        int addedCount = 0; // 0 while not added
+    };
+
+    ProjectExplorer::Task withCount(const Entry &entry) const;
+
+    const int m_maxTasks;
+    TaskHandler m_addTask;
+    TaskHandler m_removeTask;
+    QHash<QString, int> m_entryIndex; // type, file, line and description -> entry
+    QList<Entry> m_entries;
+    QList<int> m_pending;
+    int m_overflow = 0;
+    QTimer m_batchTimer;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -26,13 +26,21 @@
 #include "cmaketool.h"
 #include "cmaketoolmanager.h"
 
+#include <coreplugin/icore.h>
+
 #include <utils/algorithm.h>
 #include <utils/environment.h>
 #include <utils/qtcassert.h>
+#include <utils/runextensions.h>
+#include <utils/synchronousprocess.h>
 
+#include <QDateTime>
 #include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QProcess>
-#include <QSet>
+#include <QSettings>
 #include <QTextDocument>
 #include <QUuid>
 #include <QVariantMap>
@@ -44,6 +52,14 @@ const char CMAKE_INFORMATION_COMMAND[] = "Binary";
 const char CMAKE_INFORMATION_DISPLAYNAME[] = "DisplayName";
 const char CMAKE_INFORMATION_AUTODETECTED[] = "AutoDetected";
 
+const char CAPABILITIES_SETTINGS_KEY[] = "CMakeProjectManager/ToolCapabilities";
+const char CAPABILITIES_SIZE_KEY[] = "Size";
+const char CAPABILITIES_LAST_MODIFIED_KEY[] = "LastModified";
+const char CAPABILITIES_VERSION_KEY[] = "Version";
+const char CAPABILITIES_GENERATORS_KEY[] = "Generators";
+
+const int PROBE_TIMEOUT = 10000; // ms, nobody waits for it unless it is the first run ever
+
 ///////////////////////////
 // CMakeTool
 ///////////////////////////
@@ -51,6 +67,7 @@ CMakeTool::CMakeTool(Detection d, const Core::Id &id) :
     m_id(id), m_isAutoDetected(d == AutoDetection)
 {
     QTC_ASSERT(m_id.isValid(), m_id = Core::Id::fromString(QUuid::createUuid().toString()));
+    connect(&m_keywordBuild, &QFutureWatcher<bool>::finished, this, &CMakeTool::keywordDatabaseBuilt);
 }
 
 CMakeTool::CMakeTool(const QVariantMap &map, bool fromSdk) : m_isAutoDetected(fromSdk)
@@ -62,6 +79,7 @@ CMakeTool::CMakeTool(const QVariantMap &map, bool fromSdk) : m_isAutoDetected(fr
     if (!fromSdk)
         m_isAutoDetected = map.value(QLatin1String(CMAKE_INFORMATION_AUTODETECTED), false).toBool();
 
+    connect(&m_keywordBuild, &QFutureWatcher<bool>::finished, this, &CMakeTool::keywordDatabaseBuilt);
     setCMakeExecutable(Utils::FileName::fromString(map.value(QLatin1String(CMAKE_INFORMATION_COMMAND)).toString()));
 }
 
@@ -77,8 +95,13 @@ void CMakeTool::setCMakeExecutable(const Utils::FileName &executable)
 
     m_didRun = false;
     m_didAttemptToRun = false;
+    m_version.clear();
+    m_generators.clear();
+    m_keywords = Internal::CMakeKeywordDatabase();
 
     m_executable = executable;
+    if (!loadCapabilities())
+        startProbe();
     CMakeToolManager::notifyAboutUpdate(this);
 }
 
@@ -87,32 +110,218 @@ bool CMakeTool::isValid() const
     if (!m_id.isValid())
         return false;
 
+    waitForCapabilities();
+    return m_didRun;
+}
+
+bool CMakeTool::isValidationPending() const
+{
+    return !m_didAttemptToRun && m_probe.isRunning();
+}
+
+void CMakeTool::startProbe()
+{
+    if (m_executable.isEmpty())
+        return;
+    const Utils::FileName executable = m_executable;
+    connect(&m_probe, &QFutureWatcher<Capabilities>::finished,
+            this, &CMakeTool::probeFinished, Qt::UniqueConnection);
+    m_probe.setFuture(Utils::runAsync([executable]() { return probe(executable); }));
+}
+
+void CMakeTool::probeFinished()
+{
+    if (m_probe.future().resultCount() == 0)
+        return;
+    // Someone may have waited for the result already, the update is still due
     if (!m_didAttemptToRun)
-        supportedGenerators();
+        setCapabilities(m_probe.result());
+    CMakeToolManager::notifyAboutUpdate(this);
+}
 
-    return m_didRun;
+// Only blocks if something needs to know before the first probe of an executable finished
+void CMakeTool::waitForCapabilities() const
+{
+    if (m_didAttemptToRun)
+        return;
+    m_probe.waitForFinished();
+    if (m_probe.future().resultCount() > 0)
+        setCapabilities(m_probe.result());
+    m_didAttemptToRun = true;
 }
 
-Utils::SynchronousProcessResponse CMakeTool::run(const QString &arg) const
+void CMakeTool::setCapabilities(const Capabilities &capabilities) const
 {
-    if (m_didAttemptToRun && !m_didRun) {
-        Utils::SynchronousProcessResponse response;
-        response.result = Utils::SynchronousProcessResponse::StartFailed;
-        return response;
+    m_didAttemptToRun = true;
+    m_didRun = capabilities.didRun;
+    m_version = capabilities.version;
+    m_generators = capabilities.generators;
+    if (m_didRun) {
+        saveCapabilities();
+        if (!QFileInfo::exists(Internal::CMakeKeywordDatabase::fileName(m_version)))
+            buildKeywordDatabase();
     }
+}
 
-    Utils::SynchronousProcess cmake;
-    cmake.setTimeoutS(1);
-    cmake.setFlags(Utils::SynchronousProcess::UnixTerminalDisabled);
+CMakeTool::Capabilities CMakeTool::probe(const Utils::FileName &executable)
+{
+    QProcess cmake;
     Utils::Environment env = Utils::Environment::systemEnvironment();
     Utils::Environment::setupEnglishOutput(&env);
     cmake.setProcessEnvironment(env.toProcessEnvironment());
-    cmake.setTimeOutMessageBoxEnabled(false);
 
-    Utils::SynchronousProcessResponse response = cmake.run(m_executable.toString(), QStringList() << arg);
+    auto runCMake = [&cmake, &executable](const QStringList &arguments, QByteArray *output) {
+        cmake.start(executable.toString(), arguments);
+        if (!cmake.waitForFinished(PROBE_TIMEOUT)) {
+            cmake.kill();
+            cmake.waitForFinished();
+            return false;
+        }
+        *output = cmake.readAllStandardOutput();
+        return cmake.exitStatus() == QProcess::NormalExit && cmake.exitCode() == 0;
+    };
+
+    Capabilities capabilities;
+    QByteArray output;
+    if (runCMake(QStringList() << QLatin1String("-E") << QLatin1String("capabilities"), &output)) {
+        capabilities.generators = parseCapabilities(output);
+        capabilities.didRun = !capabilities.generators.isEmpty();
+        capabilities.version = QJsonDocument::fromJson(output).object()
+                .value(QLatin1String("version")).toObject()
+                .value(QLatin1String("string")).toString();
+    }
+    if (!capabilities.didRun && runCMake(QStringList(QLatin1String("--help")), &output)) {
+        capabilities.generators = parseHelpGenerators(
+                    Utils::SynchronousProcess::normalizeNewlines(QString::fromLocal8Bit(output)));
+        capabilities.didRun = true;
+    }
+    // "cmake version 3.5.1"
+    if (capabilities.didRun && capabilities.version.isEmpty()
+            && runCMake(QStringList(QLatin1String("--version")), &output)) {
+        const QString firstLine = QString::fromLocal8Bit(output).section(QLatin1Char('\n'), 0, 0).trimmed();
+        capabilities.version = firstLine.mid(firstLine.lastIndexOf(QLatin1Char(' ')) + 1);
+    }
+    return capabilities;
+}
+
+bool CMakeTool::loadCapabilities()
+{
+    const QFileInfo fi = m_executable.toFileInfo();
+    if (!fi.isFile())
+        return false;
+    const QVariantMap cache
+            = Core::ICore::settings()->value(QLatin1String(CAPABILITIES_SETTINGS_KEY)).toMap();
+    const QVariantMap entry = cache.value(m_executable.toString()).toMap();
+    if (entry.value(QLatin1String(CAPABILITIES_VERSION_KEY)).toString().isEmpty()
+            || entry.value(QLatin1String(CAPABILITIES_SIZE_KEY)).toLongLong() != fi.size()
+            || entry.value(QLatin1String(CAPABILITIES_LAST_MODIFIED_KEY)).toDateTime() != fi.lastModified()) {
+        return false;
+    }
+
+    m_version = entry.value(QLatin1String(CAPABILITIES_VERSION_KEY)).toString();
+    m_generators = entry.value(QLatin1String(CAPABILITIES_GENERATORS_KEY)).toStringList();
+    m_didRun = true;
     m_didAttemptToRun = true;
-    m_didRun = (response.result == Utils::SynchronousProcessResponse::Finished);
-    return response;
+    if (!QFileInfo::exists(Internal::CMakeKeywordDatabase::fileName(m_version)))
+        buildKeywordDatabase();
+    return true;
+}
+
+void CMakeTool::saveCapabilities() const
+{
+    const QFileInfo fi = m_executable.toFileInfo();
+    if (!fi.isFile())
+        return;
+
+    QSettings *settings = Core::ICore::settings();
+    QVariantMap cache = settings->value(QLatin1String(CAPABILITIES_SETTINGS_KEY)).toMap();
+    for (auto it = cache.begin(); it != cache.end(); ) {
+        if (QFileInfo(it.key()).isFile())
+            ++it;
+        else
+            it = cache.erase(it);
+    }
+
+    QVariantMap entry;
+    entry.insert(QLatin1String(CAPABILITIES_SIZE_KEY), fi.size());
+    entry.insert(QLatin1String(CAPABILITIES_LAST_MODIFIED_KEY), fi.lastModified());
+    entry.insert(QLatin1String(CAPABILITIES_VERSION_KEY), m_version);
+    entry.insert(QLatin1String(CAPABILITIES_GENERATORS_KEY), m_generators);
+    cache.insert(m_executable.toString(), entry);
+    settings->setValue(QLatin1String(CAPABILITIES_SETTINGS_KEY), cache);
+}
+
+// Generators with extra generators are listed as "<extra generator> - <generator>"
+QStringList CMakeTool::parseCapabilities(const QByteArray &json)
+{
+    QStringList generators;
+    const QJsonArray generatorList
+            = QJsonDocument::fromJson(json).object().value(QLatin1String("generators")).toArray();
+    foreach (const QJsonValue &value, generatorList) {
+        const QJsonObject generator = value.toObject();
+        const QString name = generator.value(QLatin1String("name")).toString();
+        if (name.isEmpty())
+            continue;
+        generators.append(name);
+        foreach (const QJsonValue &extra, generator.value(QLatin1String("extraGenerators")).toArray())
+            generators.append(extra.toString() + QLatin1String(" - ") + name);
+    }
+    return generators;
+}
+
+QStringList CMakeTool::parseHelpGenerators(const QString &output)
+{
+    QStringList generators;
+    bool inGeneratorSection = false;
+    const QStringList lines = output.split(QLatin1Char('\n'));
+    foreach (const QString &line, lines) {
+        if (line.isEmpty())
+            continue;
+        if (line == QLatin1String("Generators")) {
+            inGeneratorSection = true;
+            continue;
+        }
+        if (!inGeneratorSection)
+            continue;
+
+        if (line.startsWith(QLatin1String("  ")) && line.at(3) != QLatin1Char(' ')) {
+            int pos = line.indexOf(QLatin1Char('='));
+            if (pos < 0)
+                pos = line.length();
+            if (pos >= 0) {
+                --pos;
+                while (pos > 2 && line.at(pos).isSpace())
+                    --pos;
+            }
+            if (pos > 2)
+                generators.append(line.mid(2, pos - 1));
+        }
+    }
+    return generators;
+}
+
+// Other tools of the same version may be building the same file, the last one wins
+void CMakeTool::buildKeywordDatabase() const
+{
+    if (m_version.isEmpty() || m_keywordBuild.isRunning())
+        return;
+    const Utils::FileName executable = m_executable;
+    const QString fileName = Internal::CMakeKeywordDatabase::fileName(m_version);
+    m_keywordBuild.setFuture(Utils::runAsync([executable, fileName]() {
+        const Internal::CMakeKeywordDatabase database
+                = Internal::CMakeKeywordDatabase::build(executable);
+        return database.isValid() && database.save(fileName);
+    }));
+}
+
+// The keywords were asked for before, and there were none, so whoever asked is told to ask again
+void CMakeTool::keywordDatabaseBuilt()
+{
+    if (m_keywordBuild.isCanceled() || m_keywordBuild.future().resultCount() == 0
+            || !m_keywordBuild.result()) {
+        return;
+    }
+    CMakeToolManager::notifyAboutUpdate(this);
 }
 
 QVariantMap CMakeTool::toMap() const
@@ -132,64 +341,19 @@ Utils::FileName CMakeTool::cmakeExecutable() const
 
 QStringList CMakeTool::supportedGenerators() const
 {
-    if (m_generators.isEmpty()) {
-        Utils::SynchronousProcessResponse response = run(QLatin1String("--help"));
-        if (response.result == Utils::SynchronousProcessResponse::Finished) {
-            bool inGeneratorSection = false;
-            const QStringList lines = response.stdOut.split(QLatin1Char('\n'));
-            foreach (const QString &line, lines) {
-                if (line.isEmpty())
-                    continue;
-                if (line == QLatin1String("Generators")) {
-                    inGeneratorSection = true;
-                    continue;
-                }
-                if (!inGeneratorSection)
-                    continue;
-
-                if (line.startsWith(QLatin1String("  ")) && line.at(3) != QLatin1Char(' ')) {
-                    int pos = line.indexOf(QLatin1Char('='));
-                    if (pos < 0)
-                        pos = line.length();
-                    if (pos >= 0) {
-                        --pos;
-                        while (pos > 2 && line.at(pos).isSpace())
-                            --pos;
-                    }
-                    if (pos > 2)
-                        m_generators.append(line.mid(2, pos - 1));
-                }
-            }
-        }
-    }
+    waitForCapabilities();
     return m_generators;
 }
 
+// Never waits for cmake: until the tool is validated and the database of its version is built,
+// there are no keywords
 TextEditor::Keywords CMakeTool::keywords()
 {
-    if (m_functions.isEmpty()) {
-        Utils::SynchronousProcessResponse response;
-        response = run(QLatin1String("--help-command-list"));
-        if (response.result == Utils::SynchronousProcessResponse::Finished)
-            m_functions = response.stdOut.split(QLatin1Char('\n'));
-
-        response = run(QLatin1String("--help-commands"));
-        if (response.result == Utils::SynchronousProcessResponse::Finished)
-            parseFunctionDetailsOutput(response.stdOut);
-
-        response = run(QLatin1String("--help-property-list"));
-        if (response.result == Utils::SynchronousProcessResponse::Finished)
-            m_variables = parseVariableOutput(response.stdOut);
-
-        response = run(QLatin1String("--help-variable-list"));
-        if (response.result == Utils::SynchronousProcessResponse::Finished) {
-            m_variables.append(parseVariableOutput(response.stdOut));
-            m_variables = Utils::filteredUnique(m_variables);
-            Utils::sort(m_variables);
-        }
+    if (!m_keywords.isValid() && !isValidationPending() && isValid()
+            && !m_keywords.load(Internal::CMakeKeywordDatabase::fileName(m_version))) {
+        buildKeywordDatabase();
     }
-
-    return TextEditor::Keywords(m_variables, m_functions, m_functionArgs);
+    return m_keywords.keywords();
 }
 
 bool CMakeTool::isAutoDetected() const
@@ -213,100 +377,163 @@ void CMakeTool::setPathMapper(const CMakeTool::PathMapper &pathMapper)
     m_pathMapper = pathMapper;
 }
 
+void CMakeTool::setPathPrefixMapper(const CMakeTool::PathPrefixMapper &pathPrefixMapper)
+{
+    m_pathPrefixMapper = pathPrefixMapper;
+}
+
+static bool isPathDelimiter(const QChar c)
+{
+    return c.isSpace() || c == QLatin1Char('"') || c == QLatin1Char('\'') || c == QLatin1Char('=');
+}
+
+// Replaces the prefixes of all paths in text. Paths start at the beginning of text, or after
+// white space, quotes or an equals sign, as in command lines and compiler options. A prefix
+// only matches whole path components, so "/src" maps "/src/a.cpp", but not "/srcfoo".
+static void replacePathPrefixes(const CMakeTool::PathPrefixMap &prefixes, QString &text)
+{
+    for (int pos = 0; pos < text.size(); ++pos) {
+        if (pos > 0 && !isPathDelimiter(text.at(pos - 1)))
+            continue;
+        for (const QPair<QString, QString> &prefix : prefixes) {
+            if (!text.midRef(pos).startsWith(prefix.first))
+                continue;
+            const int end = pos + prefix.first.size();
+            if (!prefix.first.endsWith(QLatin1Char('/')) && end < text.size()
+                    && text.at(end) != QLatin1Char('/') && !isPathDelimiter(text.at(end))) {
+                continue;
+            }
+            text.replace(pos, prefix.first.size(), prefix.second);
+            pos += prefix.second.size() - 1;
+            break;
+        }
+    }
+}
+
+static CMakeTool::PathPrefixMap sortedPathPrefixes(CMakeTool::PathPrefixMap prefixes)
+{
+    // The most specific prefix wins
+    Utils::sort(prefixes, [](const QPair<QString, QString> &a, const QPair<QString, QString> &b) {
+        return a.first.size() > b.first.size();
+    });
+    return Utils::filtered(prefixes, [](const QPair<QString, QString> &prefix) {
+        return !prefix.first.isEmpty();
+    });
+}
+
 QString CMakeTool::mapAllPaths(const ProjectExplorer::Kit *kit, const QString &in) const
 {
+    if (m_pathPrefixMapper) {
+        QStringList paths(in);
+        mapAllPaths(kit, paths);
+        return paths.first();
+    }
     if (m_pathMapper)
         return m_pathMapper(kit, in);
     return in;
 }
 
-static QStringList parseDefinition(const QString &definition)
+// Maps many paths at once, with the mapping looked up only once.
+void CMakeTool::mapAllPaths(const ProjectExplorer::Kit *kit, QStringList &paths) const
 {
-    QStringList result;
-    QString word;
-    bool ignoreWord = false;
-    QVector<QChar> braceStack;
-
-    foreach (const QChar &c, definition) {
-        if (c == QLatin1Char('[') || c == QLatin1Char('<') || c == QLatin1Char('(')) {
-            braceStack.append(c);
-            ignoreWord = false;
-        } else if (c == QLatin1Char(']') || c == QLatin1Char('>') || c == QLatin1Char(')')) {
-            if (braceStack.isEmpty() || braceStack.takeLast() == QLatin1Char('<'))
-                ignoreWord = true;
-        }
-
-        if (c == QLatin1Char(' ') || c == QLatin1Char('[') || c == QLatin1Char('<') || c == QLatin1Char('(')
-                || c == QLatin1Char(']') || c == QLatin1Char('>') || c == QLatin1Char(')')) {
-            if (!ignoreWord && !word.isEmpty()) {
-                if (result.isEmpty() || Utils::allOf(word, [](const QChar &c) { return c.isUpper() || c == QLatin1Char('_'); }))
-                    result.append(word);
-            }
-            word.clear();
-            ignoreWord = false;
-        } else {
-            word.append(c);
+    if (m_pathPrefixMapper) {
+        const PathPrefixMap prefixes = sortedPathPrefixes(m_pathPrefixMapper(kit));
+        if (prefixes.isEmpty())
+            return;
+        for (QString &path : paths)
+            replacePathPrefixes(prefixes, path);
+    } else if (m_pathMapper) {
+        for (QString &path : paths) {
+            if (!path.isEmpty())
+                path = m_pathMapper(kit, path);
         }
     }
-    return result;
 }
 
-void CMakeTool::parseFunctionDetailsOutput(const QString &output)
-{
-    QSet<QString> functionSet;
-    functionSet.fromList(m_functions);
+} // namespace CMakeProjectManager
 
-    bool expectDefinition = false;
-    QString currentDefinition;
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
 
-    const QStringList lines = output.split(QLatin1Char('\n'));
-    for (int i = 0; i < lines.count(); ++i) {
-        const QString line = lines.at(i);
+#include <QTest>
 
-        if (line == QLatin1String("::")) {
-            expectDefinition = true;
-            continue;
-        }
+namespace CMakeProjectManager {
+namespace Internal {
 
-        if (expectDefinition) {
-            if (!line.startsWith(QLatin1Char(' ')) && !line.isEmpty()) {
-                expectDefinition = false;
-                QStringList words = parseDefinition(currentDefinition);
-                if (!words.isEmpty()) {
-                    const QString command = words.takeFirst();
-                    if (functionSet.contains(command)) {
-                        QStringList tmp = words + m_functionArgs[command];
-                        Utils::sort(tmp);
-                        m_functionArgs[command] = Utils::filteredUnique(tmp);
-                    }
-                }
-                if (!words.isEmpty() && functionSet.contains(words.at(0)))
-                    m_functionArgs[words.at(0)];
-                currentDefinition.clear();
-            } else {
-                currentDefinition.append(line.trimmed() + QLatin1Char(' '));
-            }
-        }
-    }
+void CMakeProjectPlugin::testCMakeToolPathPrefixMapping()
+{
+    CMakeTool tool(CMakeTool::ManualDetection, CMakeTool::createId());
+    tool.setPathPrefixMapper([](const ProjectExplorer::Kit *) {
+        return CMakeTool::PathPrefixMap()
+                << qMakePair(QString::fromLatin1("/src"), QString::fromLatin1("/home/user/src"))
+                << qMakePair(QString::fromLatin1("/src/generated"), QString::fromLatin1("/tmp/gen"))
+                << qMakePair(QString(), QString::fromLatin1("/ignored"));
+    });
+
+    QStringList paths = QStringList()
+            << QString::fromLatin1("/src/main.cpp")
+            << QString::fromLatin1("/src/generated/ui_main.h")
+            << QString::fromLatin1("/usr/include/src/x.h")
+            << QString::fromLatin1("/usr/bin/make -f \"/src/build/Makefile\" all")
+            << QString::fromLatin1("-I/src -DDIR=/src/data")
+            << QString::fromLatin1("/srcfoo/main.cpp")
+            << QString::fromLatin1("/src/generatedfoo/x.h \"/src\"")
+            << QString();
+    tool.mapAllPaths(nullptr, paths);
+
+    QCOMPARE(paths, QStringList()
+             << QString::fromLatin1("/home/user/src/main.cpp")
+             << QString::fromLatin1("/tmp/gen/ui_main.h")
+             << QString::fromLatin1("/usr/include/src/x.h")
+             << QString::fromLatin1("/usr/bin/make -f \"/home/user/src/build/Makefile\" all")
+             << QString::fromLatin1("-I/src -DDIR=/home/user/src/data")
+             << QString::fromLatin1("/srcfoo/main.cpp")
+             << QString::fromLatin1("/home/user/src/generatedfoo/x.h \"/home/user/src\"")
+             << QString());
+    QCOMPARE(tool.mapAllPaths(nullptr, QString::fromLatin1("/src")),
+             QString::fromLatin1("/home/user/src"));
 }
 
-QStringList CMakeTool::parseVariableOutput(const QString &output)
-{
-    const QStringList variableList = output.split(QLatin1Char('\n'));
-    QStringList result;
-    foreach (const QString &v, variableList) {
-        if (v.contains(QLatin1String("<CONFIG>"))) {
-            const QString tmp = QString(v).replace(QLatin1String("<CONFIG>"), QLatin1String("%1"));
-            result << tmp.arg(QLatin1String("DEBUG")) << tmp.arg(QLatin1String("RELEASE"))
-                   << tmp.arg(QLatin1String("MINSIZEREL")) << tmp.arg(QLatin1String("RELWITHDEBINFO"));
-        } else if (v.contains(QLatin1String("<LANG>"))) {
-            const QString tmp = QString(v).replace(QLatin1String("<LANG>"), QLatin1String("%1"));
-            result << tmp.arg(QLatin1String("C")) << tmp.arg(QLatin1String("CXX"));
-        } else if (!v.contains(QLatin1Char('<')) && !v.contains(QLatin1Char('['))) {
-            result << v;
-        }
-    }
-    return result;
+void CMakeProjectPlugin::testCMakeToolCapabilities()
+{
+    const QByteArray capabilities =
+            "{\"generators\":[{\"name\":\"Unix Makefiles\",\"extraGenerators\":"
+            "[\"CodeBlocks\",\"Kate\"],\"platformSupport\":false,\"toolsetSupport\":false},"
+            "{\"name\":\"Ninja\",\"extraGenerators\":[\"CodeBlocks\"]},"
+            "{\"name\":\"Watcom WMake\",\"extraGenerators\":[]}],"
+            "\"version\":{\"major\":3,\"minor\":7,\"string\":\"3.7.2\"},\"serverMode\":true}";
+    QCOMPARE(CMakeTool::parseCapabilities(capabilities), QStringList()
+             << QString::fromLatin1("Unix Makefiles")
+             << QString::fromLatin1("CodeBlocks - Unix Makefiles")
+             << QString::fromLatin1("Kate - Unix Makefiles")
+             << QString::fromLatin1("Ninja")
+             << QString::fromLatin1("CodeBlocks - Ninja")
+             << QString::fromLatin1("Watcom WMake"));
+    QVERIFY(CMakeTool::parseCapabilities("CMake Error: cmake -E capabilities is unknown").isEmpty());
+
+    const QString help = QString::fromLatin1(
+                "Usage\n"
+                "\n"
+                "  cmake [options] <path-to-source>\n"
+                "\n"
+                "Generators\n"
+                "\n"
+                "The following generators are available on this platform:\n"
+                "  Unix Makefiles               = Generates standard UNIX makefiles.\n"
+                "  Ninja                        = Generates build.ninja files.\n"
+                "  CodeBlocks - Ninja           = Generates CodeBlocks project files.\n"
+                "  CodeBlocks - Unix Makefiles  = Generates CodeBlocks project files.\n"
+                "  Sublime Text 2 - Unix Makefiles\n"
+                "                               = Generates Sublime Text 2 project files.\n");
+    QCOMPARE(CMakeTool::parseHelpGenerators(help), QStringList()
+             << QString::fromLatin1("Unix Makefiles")
+             << QString::fromLatin1("Ninja")
+             << QString::fromLatin1("CodeBlocks - Ninja")
+             << QString::fromLatin1("CodeBlocks - Unix Makefiles")
+             << QString::fromLatin1("Sublime Text 2 - Unix Makefiles"));
 }
 
+} // namespace Internal
 } // namespace CMakeProjectManager
+
+#endif
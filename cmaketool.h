@@ -26,15 +26,18 @@
 #pragma once
 
 #include "cmake_global.h"
+#include "cmakekeyworddatabase.h"
 
 #include <coreplugin/id.h>
 #include <texteditor/codeassist/keywordscompletionassist.h>
 
 #include <utils/fileutils.h>
-#include <utils/synchronousprocess.h>
 
+#include <QFuture>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QMap>
+#include <QPair>
 #include <QStringList>
 
 QT_FORWARD_DECLARE_CLASS(QProcess)
@@ -53,6 +56,9 @@ public:
     };
 
     typedef std::function<QString (const ProjectExplorer::Kit *, const QString &)> PathMapper;
+    // Pairs of path prefixes and their replacements
+    typedef QList<QPair<QString, QString> > PathPrefixMap;
+    typedef std::function<PathPrefixMap (const ProjectExplorer::Kit *)> PathPrefixMapper;
 
     explicit CMakeTool(Detection d, const Core::Id &id);
     explicit CMakeTool(const QVariantMap &map, bool fromSdk);
@@ -61,6 +67,9 @@ public:
     static Core::Id createId();
 
     bool isValid() const;
+    // Whether the executable is still being run for the first time. Until then, isValid() and
+    // supportedGenerators() wait for it, and CMakeToolManager::cmakeUpdated() follows.
+    bool isValidationPending() const;
 
     Core::Id id() const { return m_id; }
     QVariantMap toMap () const;
@@ -76,12 +85,38 @@ public:
     void setDisplayName(const QString &displayName);
 
     void setPathMapper(const PathMapper &includePathMapper);
+    // Takes precedence over a path mapper
+    void setPathPrefixMapper(const PathPrefixMapper &pathPrefixMapper);
     QString mapAllPaths(const ProjectExplorer::Kit *kit, const QString &in) const;
+    void mapAllPaths(const ProjectExplorer::Kit *kit, QStringList &paths) const;
+
+    // The generators in the output of "cmake -E capabilities", and of "cmake --help" for
+    // versions before 3.7, which do not know about capabilities
+    static QStringList parseCapabilities(const QByteArray &json);
+    static QStringList parseHelpGenerators(const QString &output);
 
 private:
-    Utils::SynchronousProcessResponse run(const QString &arg) const;
-    void parseFunctionDetailsOutput(const QString &output);
-    QStringList parseVariableOutput(const QString &output);
+    class Capabilities
+    {
+    public:
+        bool didRun = false;
+        QString version;
+        QStringList generators;
+    };
+
+    // cmake is run once per executable in the background, and what it said is kept
+    // across sessions for as long as the executable does not change
+    static Capabilities probe(const Utils::FileName &executable);
+    void startProbe();
+    void probeFinished();
+    void waitForCapabilities() const;
+    void setCapabilities(const Capabilities &capabilities) const;
+    bool loadCapabilities();
+    void saveCapabilities() const;
+
+    // The keywords only depend on the version of cmake, so they are asked for once per version
+    void buildKeywordDatabase() const;
+    void keywordDatabaseBuilt();
 
     Core::Id m_id;
     QString m_displayName;
@@ -89,15 +124,17 @@ private:
 
     bool m_isAutoDetected;
 
-    mutable bool m_didAttemptToRun;
-    mutable bool m_didRun;
+    mutable bool m_didAttemptToRun = false;
+    mutable bool m_didRun = false;
+    mutable QFutureWatcher<Capabilities> m_probe;
 
+    mutable QString m_version;
     mutable QStringList m_generators;
-    mutable QMap<QString, QStringList> m_functionArgs;
-    mutable QStringList m_variables;
-    mutable QStringList m_functions;
+    mutable QFutureWatcher<bool> m_keywordBuild; // whether a database was saved
+    Internal::CMakeKeywordDatabase m_keywords;
 
     PathMapper m_pathMapper;
+    PathPrefixMapper m_pathPrefixMapper;
 };
 
 } // namespace CMakeProjectManager
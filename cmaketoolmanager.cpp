@@ -31,8 +31,10 @@
 #include <utils/qtcassert.h>
 #include <utils/environment.h>
 #include <utils/algorithm.h>
+#include <utils/runextensions.h>
 
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QDebug>
 #include <QDir>
 
@@ -55,6 +57,8 @@ public:
     QList<CMakeTool *> m_cmakeTools;
     PersistentSettingsWriter *m_writer =  nullptr;
     QList<CMakeToolManager::AutodetectionHelper> m_autoDetectionHelpers;
+    // Auto detected tools from the user settings, kept if they are found again
+    QList<Id> m_previouslyAutoDetected;
 };
 static CMakeToolManagerPrivate *d = nullptr;
 
@@ -144,7 +148,8 @@ static void readAndDeleteLegacyCMakeSettings ()
     settings->endGroup();
 }
 
-static QList<CMakeTool *> autoDetectCMakeTools()
+// Only looks at the file system, so it can run in a worker thread
+static FileNameList findCMakeExecutables()
 {
     FileNameList suspects;
 
@@ -170,21 +175,46 @@ static QList<CMakeTool *> autoDetectCMakeTools()
                 suspects << FileName::fromString(fi.absoluteFilePath());
         }
     }
+    return suspects;
+}
 
-    QList<CMakeTool *> found;
+static void addAutoDetectedCMakeTools(const FileNameList &suspects)
+{
+    QList<CMakeTool *> autoDetected;
     foreach (const FileName &command, suspects) {
         auto item = new CMakeTool(CMakeTool::AutoDetection, CMakeTool::createId());
         item->setCMakeExecutable(command);
         item->setDisplayName(CMakeToolManager::tr("System CMake at %1").arg(command.toUserOutput()));
 
-        found.append(item);
+        autoDetected.append(item);
     }
 
     //execute custom helpers if available
     foreach (CMakeToolManager::AutodetectionHelper source, d->m_autoDetectionHelpers)
-        found.append(source());
+        autoDetected.append(source());
+
+    //if a tool from the user settings is marked as autodetected and NOT in the autodetected list,
+    //it is a leftover SDK provided tool. The user will not be able to edit it,
+    //so we automatically drop it
+    foreach (const Id &id, d->m_previouslyAutoDetected) {
+        const CMakeTool *currTool = CMakeToolManager::findById(id);
+        if (!currTool || Utils::anyOf(autoDetected,
+                                      Utils::equal(&CMakeTool::cmakeExecutable, currTool->cmakeExecutable()))) {
+            continue;
+        }
+        qWarning() << QString::fromLatin1("Previously SDK provided CMakeTool \"%1\" (%2) dropped.")
+                      .arg(currTool->cmakeExecutable().toUserOutput(), currTool->id().toString());
+        CMakeToolManager::deregisterCMakeTool(id);
+    }
+    d->m_previouslyAutoDetected.clear();
 
-    return found;
+    //filter out the tools that are already known
+    foreach (CMakeTool *currTool, autoDetected) {
+        if (CMakeToolManager::findByCommand(currTool->cmakeExecutable())
+                || !CMakeToolManager::registerCMakeTool(currTool)) {
+            delete currTool;
+        }
+    }
 }
 
 CMakeToolManager *CMakeToolManager::m_instance = nullptr;
@@ -309,6 +339,9 @@ CMakeTool *CMakeToolManager::findById(const Id &id)
     return Utils::findOrDefault(d->m_cmakeTools, Utils::equal(&CMakeTool::id, id));
 }
 
+// Registers the tools from the settings right away and the ones found in PATH once the
+// search in a worker thread is done. cmakeToolsLoaded() is emitted after each. Tools are
+// validated in parallel in the background, see CMakeTool::isValidationPending().
 void CMakeToolManager::restoreCMakeTools()
 {
     Core::Id defaultId;
@@ -322,43 +355,17 @@ void CMakeToolManager::restoreCMakeTools()
     //read the tools from the user settings file
     QList<CMakeTool *> readTools = readCMakeTools(userSettingsFileName(), &defaultId, false);
 
-    //autodetect tools
-    QList<CMakeTool *> autoDetected = autoDetectCMakeTools();
-
     //filter out the tools that were stored in SDK
-    for (int i = readTools.size() - 1; i >= 0; i--) {
-        CMakeTool *currTool = readTools.takeAt(i);
+    foreach (CMakeTool *currTool, readTools) {
         if (Utils::anyOf(toolsToRegister, Utils::equal(&CMakeTool::id, currTool->id()))) {
             delete currTool;
         } else {
-            //if the current tool is marked as autodetected and NOT in the autodetected list,
-            //it is a leftover SDK provided tool. The user will not be able to edit it,
-            //so we automatically drop it
-            if (currTool->isAutoDetected()) {
-                if (!Utils::anyOf(autoDetected,
-                                  Utils::equal(&CMakeTool::cmakeExecutable, currTool->cmakeExecutable()))) {
-
-                    qWarning() << QString::fromLatin1("Previously SDK provided CMakeTool \"%1\" (%2) dropped.")
-                                  .arg(currTool->cmakeExecutable().toUserOutput(), currTool->id().toString());
-
-                    delete currTool;
-                    continue;
-                }
-            }
+            if (currTool->isAutoDetected())
+                d->m_previouslyAutoDetected.append(currTool->id());
             toolsToRegister.append(currTool);
         }
     }
 
-    //filter out the tools that are already known
-    while (autoDetected.size()) {
-        CMakeTool *currTool = autoDetected.takeFirst();
-        if (Utils::anyOf(toolsToRegister,
-                         Utils::equal(&CMakeTool::cmakeExecutable, currTool->cmakeExecutable())))
-            delete currTool;
-        else
-            toolsToRegister.append(currTool);
-    }
-
     // Store all tools
     foreach (CMakeTool *current, toolsToRegister) {
         if (!registerCMakeTool(current)) {
@@ -376,6 +383,15 @@ void CMakeToolManager::restoreCMakeTools()
     // restore the legacy cmake settings only once and keep them around
     readAndDeleteLegacyCMakeSettings();
     emit m_instance->cmakeToolsLoaded();
+
+    //autodetect tools
+    auto watcher = new QFutureWatcher<FileNameList>(m_instance);
+    connect(watcher, &QFutureWatcher<FileNameList>::finished, m_instance, [watcher]() {
+        addAutoDetectedCMakeTools(watcher->result());
+        watcher->deleteLater();
+        emit m_instance->cmakeToolsLoaded();
+    });
+    watcher->setFuture(Utils::runAsync(findCMakeExecutables));
 }
 
 void CMakeToolManager::registerAutodetectionHelper(CMakeToolManager::AutodetectionHelper helper)
@@ -67,7 +67,7 @@ signals:
     void cmakeRemoved (const Core::Id &id);
     void cmakeUpdated (const Core::Id &id);
     void cmakeToolsChanged ();
-    void cmakeToolsLoaded ();
+    void cmakeToolsLoaded (); // Once for the configured and once for the auto detected tools
     void defaultCMakeChanged ();
 
 private: